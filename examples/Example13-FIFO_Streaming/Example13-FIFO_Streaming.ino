@@ -0,0 +1,128 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to stream samples through the AS7341L on-chip FIFO. The sensor free-runs and writes
+  the selected ADC channels (here F1 on ADC0 and Clear on ADC4) into its 128 entry FIFO. The sketch empties it
+  with a few bulk reads whenever it gets around to it, so samples are not lost even if the loop is slow.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// ADC0 (F1) and ADC4 (Clear)
+const byte adcMask = 0x11;
+
+// Storage for the host side ring buffer
+uint16_t fifoStorage[64];
+
+// Host side ring buffer
+SparkFun_AS7341X_FifoBuffer fifoBuffer;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+
+  // Short integration time (about 2.8 ms) for a fast sample rate
+  as7341L.setATIME(0);
+  as7341L.setASTEP(999);
+  as7341L.setGain(AS7341X_GAIN::GAIN_X64);
+
+  // Attach the ring buffer to its storage
+  fifoBuffer.begin(fifoStorage, 64);
+
+  // Start streaming
+  result = as7341L.startFifoStreaming(adcMask);
+  if (result == false)
+  {
+    PrintErrorMessage();
+    while (true) ;
+  }
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  digitalWrite(LED_BUILTIN, HIGH);
+}
+
+void loop()
+{
+  // Move whatever the sensor has collected into our buffer
+  as7341L.drainFifo(fifoBuffer);
+
+  if (fifoBuffer.overflowed())
+  {
+    Serial.println("Samples were lost, restarting stream");
+    fifoBuffer.clear();
+    fifoBuffer.clearOverflow();
+    as7341L.clearFifo();
+  }
+
+  // Entries come in ADC order, one per selected channel for each spectral cycle
+  uint16_t f1, clear;
+  while (fifoBuffer.available() >= as7341L.getFifoChannelCount())
+  {
+    fifoBuffer.pop(f1);
+    fifoBuffer.pop(clear);
+    Serial.print(f1);
+    Serial.print(",");
+    Serial.println(clear);
+  }
+
+  // Pretend to be busy with something else
+  delay(50);
+}
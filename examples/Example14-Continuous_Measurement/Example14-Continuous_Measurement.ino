@@ -0,0 +1,134 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to run the sensor in continuous mode. SP_EN stays set and the sensor's wait timer
+  (WTIME) paces one F1-F4, CLEAR and NIR sample every 250 ms on its own. updateContinuousMeasurement() only
+  checks whether a new sample is available, and the sequence number tells fresh data apart from stale data.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Sequence number of the last sample printed
+uint32_t lastSequence = 0;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  case ERROR_AS7341X_INVALID_WAIT_TIME:
+    Serial.println("Error: sample interval shorter than the integration time");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+
+  // One sample every 250 ms. The interval must be longer than the integration time.
+  if (as7341L.startContinuousMeasurement(250) == false)
+  {
+    PrintErrorMessage();
+    while (true) ;
+  }
+}
+
+void loop()
+{
+  // Cheap check, returns immediately when there is nothing new
+  as7341L.updateContinuousMeasurement();
+
+  // Array which contains F1-F4, CLEAR and NIR raw values
+  unsigned int channelReadings[6] = { 0 };
+  uint32_t sequence = as7341L.getLatestSample(channelReadings);
+
+  // Only print samples we haven't seen yet
+  if (sequence != 0 && sequence != lastSequence)
+  {
+    // If the sequence jumped we were too slow and missed some samples
+    if (lastSequence != 0 && sequence != lastSequence + 1)
+    {
+      Serial.print("Missed samples: ");
+      Serial.println(sequence - lastSequence - 1);
+    }
+    lastSequence = sequence;
+
+    Serial.println("---------------------------------");
+    Serial.print("Sequence: ");
+    Serial.print(sequence);
+    Serial.print(" at ");
+    Serial.print(as7341L.getSampleTimestamp());
+    Serial.println(" ms");
+    Serial.print("F1 (415 nm): ");
+    Serial.println(channelReadings[0]);
+    Serial.print("F2 (445 nm): ");
+    Serial.println(channelReadings[1]);
+    Serial.print("F3 (480 nm): ");
+    Serial.println(channelReadings[2]);
+    Serial.print("F4 (515 nm): ");
+    Serial.println(channelReadings[3]);
+    Serial.print("Clear: ");
+    Serial.println(channelReadings[4]);
+    Serial.print("NIR: ");
+    Serial.println(channelReadings[5]);
+    Serial.println();
+  }
+
+  // Other work goes here
+}
@@ -0,0 +1,148 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to let the sensor pick its own gain. With the spectral AGC enabled the AS7341L lowers
+  the gain after a cycle that came close to saturation and raises it after a dark one, so scenes going from a
+  dark room to direct sunlight need no retries at different gains. Basic counts are normalized with the gain
+  each pass was actually measured with, which is printed next to the results.
+  
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Sample number variable
+unsigned int sampleNumber = 0;
+
+// Gain names, indexed by AS7341X_GAIN
+const char* gainNames[] = { "0.5x", "1x", "2x", "4x", "8x", "16x", "32x", "64x", "128x", "256x", "512x", "invalid" };
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  case ERROR_AS7341X_INVALID_DEVICE:
+	Serial.println("Error: AS7341L cannot measure flicker detection");
+	break;
+	
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+
+  // Let the sensor choose the gain, up to 256x. Gain drops above 87.5% and rises below 50% of full scale.
+  as7341L.enableAutomaticGain(AS7341X_GAIN::GAIN_X256, AS7341X_AGC_LOW_HYSTERESIS::PERCENT_50, AS7341X_AGC_HIGH_HYSTERESIS::PERCENT_87_5);
+}
+
+void loop()
+{  
+  // Array which contains all channels processed values
+  float channelReadings[12];
+
+  // Read all channels
+  bool result = as7341L.readAllChannelsBasicCounts(channelReadings);
+
+  // Check if the read operation was successful and print out results with 5 decimal digits
+  if (result == true)
+  {
+    Serial.println("---------------------------------");
+    Serial.print("Sample number: ");
+    Serial.println(++sampleNumber);
+    Serial.print("Gain F1-F4: ");
+    Serial.print(gainNames[(int)as7341L.getMeasurementGain(0)]);
+    if (as7341L.isMeasurementSaturated(0))
+      Serial.print(" (saturated)");
+    Serial.println();
+    Serial.print("Gain F5-F8: ");
+    Serial.print(gainNames[(int)as7341L.getMeasurementGain(1)]);
+    if (as7341L.isMeasurementSaturated(1))
+      Serial.print(" (saturated)");
+    Serial.println();
+    Serial.println();
+    Serial.print("F1 (415 nm): ");
+    Serial.println(channelReadings[0],5);
+    Serial.print("F2 (445 nm): ");
+    Serial.println(channelReadings[1],5);
+    Serial.print("F3 (480 nm): ");
+    Serial.println(channelReadings[2],5);
+    Serial.print("F4 (515 nm): ");
+    Serial.println(channelReadings[3],5);
+    // channelReadings[4] and [5] hold Clear and NIR values, respectively (same as [10] and [11])
+    Serial.print("F5 (555 nm): ");
+    Serial.println(channelReadings[6],5);
+    Serial.print("F6 (590 nm): ");
+    Serial.println(channelReadings[7],5);
+    Serial.print("F7 (630 nm): ");
+    Serial.println(channelReadings[8],5);
+    Serial.print("F8 (680 nm): ");
+    Serial.println(channelReadings[9],5);
+    Serial.print("Clear: ");
+    Serial.println(channelReadings[10],5);
+    Serial.print("NIR: ");
+    Serial.println(channelReadings[11],5);
+    Serial.println();
+  }
+  else
+  {
+    // Ooops ! We got an error !
+    PrintErrorMessage();
+  }
+
+  // Wait 1 second and start over
+  delay(1000);
+}
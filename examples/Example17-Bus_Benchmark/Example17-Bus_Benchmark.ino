@@ -0,0 +1,210 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example measures what the main read paths cost on the I2C bus. Every call is run once and reported as a
+  JSON line with its transaction count, bytes on the wire, bank switches, measured wall time and the bus time
+  modelled for 100 kHz, 400 kHz and 1 MHz clocks. Calls going over their transaction budget are flagged, so a
+  host script reading the serial port can fail a build when bus cost regresses.
+
+  The I2C counters are compiled out by default. Set AS7341X_IO_STATS to 1 in SparkFun_AS7341X_Constants.h (or
+  pass -DAS7341X_IO_STATS=1 to the whole build) before running this example. Defining it in the sketch alone is
+  not enough, the library must be built with it too. Without it the sketch only prints how to enable them.
+
+  The same calls can be benchmarked without a board: extras/host builds bus_benchmark against a simulated sensor
+  and checks the results against extras/host/bench/bus_budget.json.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+#if AS7341X_IO_STATS
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Scratch buffers for the calls under test
+unsigned int rawReadings[12];
+float basicCountReadings[12];
+
+// One benchmarked call and the most transactions it may use (0 = no budget). Calls that wait for a measurement
+// poll the sensor, so their count grows with the integration time: budget them from a known good run on your setup.
+struct Benchmark
+{
+  const char* name;
+  void (*run)();
+  unsigned long budget;
+};
+
+Benchmark benchmarks[] =
+{
+  { "begin", [] { as7341L.begin(); as7341L.enable_AS7341X(); }, 32 },
+  { "readAllChannels", [] { as7341L.readAllChannels(rawReadings); }, 0 },
+  { "readAllChannelsBasicCounts", [] { as7341L.readAllChannelsBasicCounts(basicCountReadings); }, 0 },
+  { "read415nm", [] { as7341L.read415nm(); }, 0 },
+  { "read445nm", [] { as7341L.read445nm(); }, 0 },
+  { "read480nm", [] { as7341L.read480nm(); }, 0 },
+  { "read515nm", [] { as7341L.read515nm(); }, 0 },
+  { "read555nm", [] { as7341L.read555nm(); }, 0 },
+  { "read590nm", [] { as7341L.read590nm(); }, 0 },
+  { "read630nm", [] { as7341L.read630nm(); }, 0 },
+  { "read680nm", [] { as7341L.read680nm(); }, 0 },
+  { "readClear", [] { as7341L.readClear(); }, 0 },
+  { "readNIR", [] { as7341L.readNIR(); }, 0 },
+  { "readBasicCount415nm", [] { as7341L.readBasicCount415nm(); }, 0 },
+  { "readBasicCount445nm", [] { as7341L.readBasicCount445nm(); }, 0 },
+  { "readBasicCount480nm", [] { as7341L.readBasicCount480nm(); }, 0 },
+  { "readBasicCount515nm", [] { as7341L.readBasicCount515nm(); }, 0 },
+  { "readBasicCount555nm", [] { as7341L.readBasicCount555nm(); }, 0 },
+  { "readBasicCount590nm", [] { as7341L.readBasicCount590nm(); }, 0 },
+  { "readBasicCount630nm", [] { as7341L.readBasicCount630nm(); }, 0 },
+  { "readBasicCount680nm", [] { as7341L.readBasicCount680nm(); }, 0 },
+  { "readBasicCountClear", [] { as7341L.readBasicCountClear(); }, 0 },
+  { "readBasicCountNIR", [] { as7341L.readBasicCountNIR(); }, 0 },
+  { "getFlickerFrequency", [] { as7341L.getFlickerFrequency(); }, 0 },
+};
+
+// Bus clocks the transfer time is modelled for, and their JSON key suffix
+const unsigned long busClocks[] = { 100000, 400000, 1000000 };
+const char* busClockNames[] = { "100k", "400k", "1m" };
+
+// Number of transactions over budget in the last run
+unsigned int failures = 0;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  case ERROR_AS7341X_INVALID_DEVICE:
+	Serial.println("Error: AS7341L cannot measure flicker detection");
+	break;
+	
+  default:
+    break;
+  }
+}
+
+// Bus time of the counted traffic at clockHz: start, address and stop per transaction, 9 clocks per data byte
+unsigned long ModelledMicros(const SparkFun_AS7341X_IOStats& stats, unsigned long clockHz)
+{
+  unsigned long long bits = 11ULL * stats.transactions + 9ULL * (stats.bytesWritten + stats.bytesRead);
+  return (unsigned long)(bits * 1000000ULL / clockHz);
+}
+
+void RunBenchmark(const Benchmark& benchmark)
+{
+  as7341L.resetIOStats();
+  unsigned long start = micros();
+  benchmark.run();
+  unsigned long wallTime = micros() - start;
+
+  SparkFun_AS7341X_IOStats stats;
+  as7341L.getIOStats(stats);
+  bool withinBudget = (benchmark.budget == 0) || (stats.transactions <= benchmark.budget);
+  if (!withinBudget)
+    failures++;
+
+  Serial.print("{\"call\":\"");
+  Serial.print(benchmark.name);
+  Serial.print("\",\"transactions\":");
+  Serial.print(stats.transactions);
+  Serial.print(",\"bytes_written\":");
+  Serial.print(stats.bytesWritten);
+  Serial.print(",\"bytes_read\":");
+  Serial.print(stats.bytesRead);
+  Serial.print(",\"bank_switches\":");
+  Serial.print(stats.bankSwitches);
+  Serial.print(",\"nacks\":");
+  Serial.print(stats.nacks);
+  Serial.print(",\"bus_us\":");
+  Serial.print(stats.busMicros);
+  Serial.print(",\"wall_us\":");
+  Serial.print(wallTime);
+  for (unsigned int i = 0; i < sizeof(busClocks) / sizeof(busClocks[0]); i++)
+  {
+    Serial.print(",\"model_us_");
+    Serial.print(busClockNames[i]);
+    Serial.print("\":");
+    Serial.print(ModelledMicros(stats, busClocks[i]));
+  }
+  Serial.print(",\"error\":");
+  Serial.print((int)as7341L.getLastError());
+  Serial.print(",\"within_budget\":");
+  Serial.print(withinBudget ? "true" : "false");
+  Serial.println("}");
+}
+
+void setup()
+{
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  if (as7341L.begin() == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+}
+
+void loop()
+{
+  failures = 0;
+  for (unsigned int i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    RunBenchmark(benchmarks[i]);
+
+  // Summary line, a host script can stop reading here
+  Serial.print("{\"summary\":true,\"calls\":");
+  Serial.print(sizeof(benchmarks) / sizeof(benchmarks[0]));
+  Serial.print(",\"over_budget\":");
+  Serial.print(failures);
+  Serial.println("}");
+
+  // Run again every 10 seconds
+  delay(10000);
+}
+
+#else
+
+void setup()
+{
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+  Serial.println("I2C counters are disabled: set AS7341X_IO_STATS to 1 in SparkFun_AS7341X_Constants.h and rebuild.");
+  Serial.println("Or run the bus_benchmark host build in extras/host, no board needed.");
+}
+
+void loop()
+{
+}
+
+#endif
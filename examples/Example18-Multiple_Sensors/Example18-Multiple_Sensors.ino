@@ -0,0 +1,100 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to read several AS7341L boards sitting behind a Qwiic Mux (TCA9548A). All sensors
+  share the same I2C address, so the manager switches the mux before talking to each one. Measurements are
+  started on every sensor at once and serviced as they finish, so a full cycle takes about as long as reading
+  a single sensor.
+
+  Hardware Connections:
+  - Plug a Qwiic Mux to your Arduino/Photon/ESP32 and one AS7341L board on each of its ports 0 to 3
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Number of sensors, one on each mux port starting at port 0
+const byte SENSOR_COUNT = 4;
+
+// TCA9548A default address
+const byte MUX_ADDRESS = 0x70;
+
+// One object per board
+SparkFun_AS7341X sensors[SENSOR_COUNT];
+
+// Manager overlapping their measurements
+SparkFun_AS7341X_Manager manager;
+
+// Enables a single mux port
+void SelectMuxPort(byte port, void*)
+{
+  Wire.beginTransmission(MUX_ADDRESS);
+  Wire.write(1 << port);
+  Wire.endTransmission();
+}
+
+void setup()
+{
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Tell the manager how to reach each sensor
+  manager.setMuxSelect(SelectMuxPort);
+  for (byte i = 0; i < SENSOR_COUNT; i++)
+    manager.addSensor(sensors[i], Wire, i);
+
+  // Initialize and power up every sensor
+  if (manager.beginAll() == false)
+  {
+    Serial.println("At least one AS7341L did not answer. Check your connections. System halted !");
+    while (true) ;
+  }
+}
+
+void loop()
+{
+  unsigned long start = millis();
+
+  // Start every sensor, then handle each one as soon as it is done
+  manager.startAll();
+  while (!manager.isComplete())
+  {
+    int index = manager.service();
+    if (index < 0)
+      continue;
+
+    unsigned int channelReadings[12] = { 0 };
+    manager.getResult(index, channelReadings);
+
+    Serial.print("Sensor ");
+    Serial.print(index);
+    Serial.print(": F1 ");
+    Serial.print(channelReadings[0]);
+    Serial.print(" F4 ");
+    Serial.print(channelReadings[3]);
+    Serial.print(" F8 ");
+    Serial.print(channelReadings[9]);
+    Serial.print(" Clear ");
+    Serial.print(channelReadings[10]);
+    Serial.print(" NIR ");
+    Serial.println(channelReadings[11]);
+  }
+
+  Serial.print("Cycle time: ");
+  Serial.print(millis() - start);
+  Serial.print(" ms, errors: ");
+  Serial.println(manager.getErrorCount());
+  Serial.println();
+
+  delay(1000);
+}
@@ -0,0 +1,126 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to define your own SMUX configuration. The routes from photodiodes to ADCs are listed
+  in the sketch and the compiler turns them into the 20 byte SMUX RAM image, stored in flash. No RAM and no
+  run time computation are needed, and a single integration reads all routed channels.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Short names for the route list below
+typedef AS7341X_PHOTODIODE PD;
+typedef SparkFun_AS7341X_Smux Smux;
+
+// F1 on ADC0, F8 on ADC1, Clear on ADC2 and NIR on ADC3. ADC4 and ADC5 are left unconnected.
+static const byte blueRedSmux[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(
+  Smux::route(PD::F1, 0), Smux::route(PD::F8, 1), Smux::route(PD::CLEAR, 2), Smux::route(PD::NIR, 3));
+
+// Sample number variable
+unsigned int sampleNumber = 0;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  case ERROR_AS7341X_INVALID_DEVICE:
+	Serial.println("Error: AS7341L cannot measure flicker detection");
+	break;
+	
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+}
+
+void loop()
+{
+  // ADC0 to ADC5 readings
+  unsigned int adcReadings[6] = { 0 };
+
+  // Apply our SMUX configuration and read the ADCs
+  bool result = as7341L.readSmuxTable(blueRedSmux, adcReadings);
+
+  // Check if the read operation was successful and print out results
+  if (result == true)
+  {
+    Serial.println("---------------------------------");
+    Serial.print("Sample number: ");
+    Serial.println(++sampleNumber);
+    Serial.println();
+    Serial.print("F1 (415 nm): ");
+    Serial.println(adcReadings[0]);
+    Serial.print("F8 (680 nm): ");
+    Serial.println(adcReadings[1]);
+    Serial.print("Clear: ");
+    Serial.println(adcReadings[2]);
+    Serial.print("NIR: ");
+    Serial.println(adcReadings[3]);
+    Serial.println();
+  }
+  else
+  {
+    // Ooops ! We got an error !
+    PrintErrorMessage();
+  }
+
+  // Wait 1 second and start over
+  delay(1000);
+}
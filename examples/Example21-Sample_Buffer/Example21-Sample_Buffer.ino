@@ -0,0 +1,146 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to decouple acquisition from processing with a sample ring buffer. The producer side
+  runs non-blocking measurements and stores each result, with its timestamp, gain, integration settings and
+  saturation flags, straight into the buffer. The consumer side drains the buffer in batches every second, so a
+  slow serial port never stalls acquisition. Samples that do not fit are counted instead of blocking.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Ring buffer and its storage (one slot is kept free, so this holds 15 samples)
+AS7341X_SAMPLE sampleStorage[16];
+SparkFun_AS7341X_SampleBuffer samples;
+
+// Time of the last batch printed
+unsigned long lastBatch = 0;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+
+  // Attach the buffer to its storage
+  samples.begin(sampleStorage, 16);
+
+  // Kick off the first measurement
+  as7341L.startMeasurement();
+}
+
+void loop()
+{
+  // Producer: store each finished measurement in place and start the next one
+  if (as7341L.poll())
+  {
+    AS7341X_SAMPLE* slot = samples.reserve();
+    if (slot != nullptr)
+    {
+      as7341L.getResult(*slot);
+      samples.commit();
+    }
+    else
+    {
+      // Full: let push() count the dropped sample
+      AS7341X_SAMPLE sample;
+      as7341L.getResult(sample);
+      samples.push(sample);
+    }
+    as7341L.startMeasurement();
+  }
+  else if (as7341L.getMeasurementState() == AS7341X_MEASUREMENT_STATE::ERROR)
+  {
+    PrintErrorMessage();
+    as7341L.startMeasurement();
+  }
+
+  // Consumer: print everything collected once per second
+  if (millis() - lastBatch < 1000)
+    return;
+  lastBatch = millis();
+
+  Serial.print("Batch of ");
+  Serial.print(samples.available());
+  Serial.print(" samples, dropped so far: ");
+  Serial.println(samples.getDroppedCount());
+
+  const AS7341X_SAMPLE* sample;
+  while ((sample = samples.peek()) != nullptr)
+  {
+    Serial.print(sample->timestamp);
+    Serial.print(" us  gain codes ");
+    Serial.print(sample->gain & 0x0f);
+    Serial.print("/");
+    Serial.print(sample->gain >> 4);
+    Serial.print("  F4 ");
+    Serial.print(sample->channels[3]);
+    Serial.print("  Clear ");
+    Serial.print(sample->channels[10]);
+    if (sample->flags & (AS7341X_SAMPLE_SATURATED_LOW | AS7341X_SAMPLE_SATURATED_HIGH))
+      Serial.print("  saturated");
+    Serial.println();
+    samples.release();
+  }
+  Serial.println();
+}
@@ -0,0 +1,134 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to capture the raw flicker photodiode waveform and find its dominant frequency and
+  modulation depth. Unlike getFlickerFrequency(), which only tells 100 Hz from 120 Hz, this works for any
+  frequency up to just under half the sample rate, such as PWM dimmed LEDs running at 1 to 2 kHz.
+  The samples are streamed through the sensor's FIFO and analyzed with a bank of Goertzel filters.
+  Only works on the AS7341 - the AS7341L has no flicker detection.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341 object
+SparkFun_AS7341X as7341(AS7341X_DEVICE::AS7341);
+
+// Waveform analyzer
+SparkFun_AS7341X_FlickerAnalyzer analyzer;
+
+// Captured waveform: 256 samples at 5 kHz cover about 51 ms
+const uint16_t sampleCount = 256;
+uint16_t samples[sampleCount];
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341 I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341 measurement timeout");
+    break;
+    
+  case ERROR_AS7341X_INVALID_DEVICE:
+    Serial.println("Error: AS7341L cannot measure flicker");
+    break;
+    
+  case ERROR_AS7341X_FIFO_OVERFLOW:
+    Serial.println("Error: FIFO overflow, the I2C bus is too slow for this sample rate");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port at 400 kHz to keep up with the FIFO
+  Wire.begin();
+  Wire.setClock(400000);
+
+  // Initialize AS7341
+  boolean result = as7341.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341 to the powered up state
+  as7341.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+
+  // Look for anything between 50 Hz and the 2.5 kHz Nyquist limit
+  analyzer.setFrequencyRange(50, 2500);
+}
+
+void loop()
+{
+  if (as7341.captureFlickerWaveform(samples, sampleCount, 5000))
+  {
+    AS7341X_FLICKER_RESULT flicker;
+    analyzer.analyze(samples, sampleCount, as7341.getFlickerSampleRate(), flicker);
+
+    Serial.println("---------------------------------");
+    if (flicker.frequency == 0)
+      Serial.println("Steady light");
+    else
+    {
+      Serial.print("Dominant frequency: ");
+      Serial.print(flicker.frequency, 1);
+      Serial.println(" Hz");
+    }
+    Serial.print("Modulation depth: ");
+    Serial.print(flicker.modulationDepth * 100, 1);
+    Serial.println(" %");
+    Serial.print("Mean / min / max: ");
+    Serial.print(flicker.mean);
+    Serial.print(" / ");
+    Serial.print(flicker.minimum);
+    Serial.print(" / ");
+    Serial.println(flicker.maximum);
+    Serial.println();
+  }
+  else
+  {
+    // Ooops ! We got an error !
+    PrintErrorMessage();
+  }
+
+  // Wait 1 second and start over
+  delay(1000);
+}
@@ -0,0 +1,139 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to keep flicker detection running in the background while spectral measurements
+  go on. Flicker detection is configured once, the flicker photodiode stays routed to ADC5 and
+  updateFlickerDetection() just picks up each new result, so neither pipeline waits for the other.
+  While flicker detection runs the NIR channel is not measured and reads 0.
+  Only works on the AS7341 - the AS7341L has no flicker detection.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341 object
+SparkFun_AS7341X as7341(AS7341X_DEVICE::AS7341);
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341 I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341 measurement timeout");
+    break;
+    
+  case ERROR_AS7341X_INVALID_DEVICE:
+    Serial.println("Error: AS7341L cannot measure flicker");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341
+  boolean result = as7341.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341 to the powered up state
+  as7341.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+
+  // Configure flicker detection once and leave it running
+  if (as7341.startFlickerDetection() == false)
+  {
+    PrintErrorMessage();
+    while (true) ;
+  }
+
+  // Kick off the first spectral measurement
+  as7341.startMeasurement();
+}
+
+void loop()
+{
+  // Pick up a new flicker result if there is one
+  if (as7341.updateFlickerDetection())
+  {
+    Serial.print("Flicker #");
+    Serial.print(as7341.getFlickerSequence());
+    Serial.print(": ");
+    switch (as7341.getFlickerResult())
+    {
+    case 100:
+      Serial.print("100 Hz");
+      break;
+
+    case 120:
+      Serial.print("120 Hz");
+      break;
+
+    default:
+      Serial.print("none or unknown");
+      break;
+    }
+    if (as7341.isFlickerSaturated())
+      Serial.print(" (saturated)");
+    Serial.println();
+  }
+
+  // Spectral measurements carry on independently
+  if (as7341.poll())
+  {
+    unsigned int channelReadings[12] = { 0 };
+    as7341.getResult(channelReadings);
+
+    Serial.print("F4 (515 nm): ");
+    Serial.print(channelReadings[3]);
+    Serial.print("  Clear: ");
+    Serial.println(channelReadings[10]);
+
+    as7341.startMeasurement();
+  }
+  else if (as7341.getMeasurementState() == AS7341X_MEASUREMENT_STATE::ERROR)
+  {
+    PrintErrorMessage();
+    as7341.startMeasurement();
+  }
+}
@@ -0,0 +1,123 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to take ambient-subtracted reflectance readings with the on-board white LED.
+  readAllChannelsDifferential() integrates with the LED off and on back to back for each SMUX
+  configuration and returns the difference, so only two SMUX setups are needed and the LED is lit
+  for just two integrations per reading.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+
+  // LED current in mA
+  as7341L.setLedDrive(10);
+}
+
+void loop()
+{
+  unsigned int reflected[12] = { 0 };
+  unsigned int ambient[12] = { 0 };
+
+  if (as7341L.readAllChannelsDifferential(AS7341X_LED::WHITE, reflected, ambient))
+  {
+    Serial.println("---------------------------------");
+    if (as7341L.isMeasurementSaturated(0) || as7341L.isMeasurementSaturated(1))
+      Serial.println("Saturated, lower the gain or the LED current");
+    Serial.println("Channel: LED only (ambient)");
+    Serial.print("F1 (415 nm): ");
+    Serial.print(reflected[0]);
+    Serial.print(" (");
+    Serial.print(ambient[0]);
+    Serial.println(")");
+    Serial.print("F4 (515 nm): ");
+    Serial.print(reflected[3]);
+    Serial.print(" (");
+    Serial.print(ambient[3]);
+    Serial.println(")");
+    Serial.print("F8 (680 nm): ");
+    Serial.print(reflected[9]);
+    Serial.print(" (");
+    Serial.print(ambient[9]);
+    Serial.println(")");
+    Serial.print("Clear: ");
+    Serial.print(reflected[10]);
+    Serial.print(" (");
+    Serial.print(ambient[10]);
+    Serial.println(")");
+    Serial.println();
+  }
+  else
+  {
+    // Ooops ! We got an error !
+    PrintErrorMessage();
+  }
+
+  // Wait 1 second and start over
+  delay(1000);
+}
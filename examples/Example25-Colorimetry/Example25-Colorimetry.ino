@@ -0,0 +1,132 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to turn the spectral reading into CIE 1931 XYZ, chromaticity, illuminance and
+  correlated color temperature. The built-in correction matrix is fitted to the nominal filter responses
+  and gives relative values; for accurate results calibrate a 3 x 10 matrix against a reference instrument
+  and load it with setMatrix_P() (flash) or setMatrix() (e.g. after EEPROM.get()). Send 'c' with a lux
+  meter reading next to the sensor, e.g. "c 350", to calibrate the lux scale.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Colorimetry engine, starts with the built-in matrix
+SparkFun_AS7341X_Colorimetry colorimetry;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+}
+
+void loop()
+{
+  float basicCounts[12] = { 0 };
+
+  if (as7341L.readAllChannelsBasicCounts(basicCounts))
+  {
+    // Calibrate the lux scale on request
+    if (Serial.available() && Serial.read() == 'c')
+    {
+      float referenceLux = Serial.parseFloat();
+      if (colorimetry.calibrateLux(basicCounts, referenceLux))
+        Serial.println("Lux scale calibrated");
+    }
+
+    AS7341X_COLOR color;
+    colorimetry.convert(basicCounts, color);
+
+    Serial.println("---------------------------------");
+    Serial.print("X / Y / Z: ");
+    Serial.print(color.X, 4);
+    Serial.print(" / ");
+    Serial.print(color.Y, 4);
+    Serial.print(" / ");
+    Serial.println(color.Z, 4);
+    Serial.print("x, y: ");
+    Serial.print(color.x, 4);
+    Serial.print(", ");
+    Serial.println(color.y, 4);
+    Serial.print("Illuminance: ");
+    Serial.print(color.lux, 1);
+    Serial.println(" lux");
+    Serial.print("CCT: ");
+    if (color.cct == 0)
+      Serial.println("not white light");
+    else
+    {
+      Serial.print(color.cct, 0);
+      Serial.println(" K");
+    }
+    Serial.println();
+  }
+  else
+  {
+    // Ooops ! We got an error !
+    PrintErrorMessage();
+  }
+
+  // Wait 1 second and start over
+  delay(1000);
+}
@@ -0,0 +1,80 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to stream samples as compact binary frames instead of text. Each frame carries
+  the raw channels, gain, integration settings, saturation flags, a timestamp, a sequence number and a
+  CRC. Most frames only hold the change since the previous sample and take about 25 bytes instead of the
+  150 or so needed as text, so the serial port keeps up with the sensor.
+
+  The serial monitor will show gibberish: capture the port on the computer and decode it with
+  extras/decode_frames.py, e.g. python3 decode_frames.py --port /dev/ttyUSB0 --baud 115200 > samples.csv
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Capture the serial port at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Frame encoder: a key frame every 16 frames lets the decoder join at any time
+SparkFun_AS7341X_FrameEncoder encoder;
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L. Errors can't be printed as text on a binary stream, so just halt with LED_BUILTIN off.
+  if (as7341L.begin() == false)
+  {
+    digitalWrite(LED_BUILTIN, LOW);
+    while (true) ;
+  }
+
+  // Bring AS7341L to the powered up state
+  as7341L.enable_AS7341X();
+  digitalWrite(LED_BUILTIN, HIGH);
+
+  // Short integration time (about 10 ms per pass) for a high sample rate
+  as7341L.setATIME(0);
+  as7341L.setASTEP(3599);
+  as7341L.setGain(AS7341X_GAIN::GAIN_X64);
+
+  encoder.setKeyFrameInterval(16);
+
+  // Kick off the first measurement
+  as7341L.startMeasurement();
+}
+
+void loop()
+{
+  if (as7341L.poll())
+  {
+    AS7341X_SAMPLE sample;
+    as7341L.getResult(sample);
+    as7341L.startMeasurement();
+
+    encoder.write(sample, Serial);
+  }
+  else if (as7341L.getMeasurementState() == AS7341X_MEASUREMENT_STATE::ERROR)
+  {
+    // Skip the failed measurement and start over
+    as7341L.startMeasurement();
+  }
+}
@@ -0,0 +1,149 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to take one sample every few seconds while keeping the sensor asleep in between.
+  In HOST_TIMED mode the scheduler powers the sensor down after every sample and wakes it up just early
+  enough for the next one to be ready on time. In SENSOR_TIMED mode the sensor's own wait timer paces the
+  samples and it sleeps after each one until it is collected. Every ten samples the achieved duty cycle and
+  the estimated energy per sample are printed. Send 'h' or 's' to switch modes.
+
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Scheduler driving the sensor
+SparkFun_AS7341X_LowPower scheduler(as7341L);
+
+// Time between samples
+const unsigned long SAMPLE_INTERVAL_MS = 2000;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+  switch (as7341L.getLastError())
+  {
+  case ERROR_AS7341X_I2C_COMM_ERROR:
+    Serial.println("Error: AS7341L I2C communication error");
+    break;
+
+  case ERROR_PCA9536_I2C_COMM_ERROR:
+    Serial.println("Error: PCA9536 I2C communication error");
+    break;
+    
+  case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+    Serial.println("Error: AS7341L measurement timeout");
+    break;
+    
+  default:
+    break;
+  }
+}
+
+// Starts the scheduler in the requested mode
+void StartScheduler(AS7341X_POWER_SCHEDULE schedule)
+{
+  if (scheduler.start(SAMPLE_INTERVAL_MS, schedule) == false)
+  {
+    PrintErrorMessage();
+    while (true) ;
+  }
+
+  if (schedule == AS7341X_POWER_SCHEDULE::HOST_TIMED)
+    Serial.println("Host timed: powered down between samples, all 12 channels");
+  else
+    Serial.println("Sensor timed: WTIME paced, sleep after interrupt, F1-F4, CLEAR and NIR");
+}
+
+void setup()
+{
+  // Configure Arduino's built in LED as output
+  pinMode(LED_BUILTIN, OUTPUT);
+
+  // Initialize serial port at 115200 bps
+  Serial.begin(115200);
+
+  // Initialize the I2C port
+  Wire.begin();
+
+  // Initialize AS7341L
+  boolean result = as7341L.begin();
+
+  // If the board did not properly initialize print an error message and halt the system
+  if (result == false)
+  {
+    PrintErrorMessage();
+    Serial.println("Check your connections. System halted !");
+    digitalWrite(LED_BUILTIN, LOW); 
+    while (true) ;
+  }
+
+  // The board's power LED draws far more than the sensor, turn it off on battery powered builds
+  as7341L.disablePowerLed();
+
+  // If the board was properly initialized, turn on LED_BUILTIN
+  if (result == true)
+    digitalWrite(LED_BUILTIN, HIGH);
+
+  // Supply voltage and sensor currents used for the energy estimate. Put your own measurements here.
+  scheduler.setSupply(1.8, 300, 45, 1);
+
+  StartScheduler(AS7341X_POWER_SCHEDULE::HOST_TIMED);
+}
+
+void loop()
+{
+  // Switch modes on request
+  if (Serial.available())
+  {
+    char command = Serial.read();
+    if (command == 'h')
+      StartScheduler(AS7341X_POWER_SCHEDULE::HOST_TIMED);
+    else if (command == 's')
+      StartScheduler(AS7341X_POWER_SCHEDULE::SENSOR_TIMED);
+  }
+
+  if (scheduler.service())
+  {
+    AS7341X_SAMPLE sample;
+    scheduler.getResult(sample);
+
+    Serial.print("Sample ");
+    Serial.print(scheduler.getSampleCount());
+    Serial.print(": Clear ");
+    Serial.print(sample.channels[4]);
+    Serial.print(", wake to valid ");
+    Serial.print(scheduler.getLastLatency());
+    Serial.println(" us");
+
+    if (scheduler.getSampleCount() % 10 == 0)
+    {
+      Serial.print("Minimum latency: ");
+      Serial.print(scheduler.getMinimumLatency());
+      Serial.print(" us, duty cycle: ");
+      Serial.print(scheduler.getDutyCycle(), 2);
+      Serial.print(" %, energy per sample: ");
+      Serial.print(scheduler.getEnergyPerSample(), 1);
+      Serial.print(" uJ, average current: ");
+      Serial.print(scheduler.getAverageCurrent(), 1);
+      Serial.println(" uA");
+    }
+  }
+
+  // A real node would put the MCU to sleep for this long
+  unsigned long idle = scheduler.getIdleTime();
+  if (idle > 0)
+    delay(idle > 100 ? 100 : idle);
+}
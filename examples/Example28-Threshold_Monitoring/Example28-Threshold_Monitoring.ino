@@ -0,0 +1,185 @@
+/*
+  Using the AS7341L 10 channel spectral sensor
+  By: Ricardo Ramos
+  SparkFun Electronics
+  Date: October 17th, 2026
+  SparkFun code, firmware, and software is released under the MIT License. Please see LICENSE.md for further details.
+  Feel like supporting our work? Buy a board from SparkFun!
+  https://www.sparkfun.com/products/17719
+
+  This example shows how to watch one channel (F7, 630 nm) for changes without any I2C traffic while the light
+  is stable. The sensor measures on its own every 100 ms, compares F7 with a window around the current level
+  and only pulls INT low when it stays outside the window for two cycles in a row. The full spectrum of that
+  moment is then printed and the window is moved to the new level.
+  
+  INT pin is 3.3V tolerant.
+  
+  Hardware Connections:
+  - Plug the Qwiic device to your Arduino/Photon/ESP32 using a cable
+  - Connect a jumper wire from the INT pin in the Qwiic shield to pin 2 of your Arduino/Photon/ESP32 board.
+  - Open a serial monitor at 115200bps
+*/
+
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Main AS7341L object
+SparkFun_AS7341X as7341L;
+
+// Pin 2 is used as an interrupt input pin
+const byte interruptPin = 2;
+
+// Monitored channel, index into F1 to F8, Clear and NIR
+const byte MONITORED_CHANNEL = 6;
+
+// Position of the monitored channel in the 12 entry readAllChannels layout
+const byte MONITORED_INDEX = 8;
+
+// Window half width, in percent of the current level
+const unsigned int WINDOW_PERCENT = 15;
+
+// Print a friendly error message
+void PrintErrorMessage()
+{
+	switch (as7341L.getLastError())
+	{
+	case ERROR_AS7341X_I2C_COMM_ERROR:
+		Serial.println("Error: AS7341X I2C communication error");
+		break;
+
+	case ERROR_PCA9536_I2C_COMM_ERROR:
+		Serial.println("Error: PCA9536 I2C communication error");
+		break;
+    
+	case ERROR_AS7341X_MEASUREMENT_TIMEOUT:
+		Serial.println("Error: AS7341X measurement timeout");
+		break;
+		
+	default:
+		break;
+	}
+}
+
+// This function will be called whenever AS7341L pulls the INT pin low
+void interruptServiceRoutine()
+{
+	// Only raise a flag, the I2C work happens in updateThresholdMonitoring()
+	as7341L.notifyInterrupt();
+}
+
+// Lower and upper window limits around a level
+unsigned int LowLimit(unsigned int level)
+{
+	return level - (unsigned long)level * WINDOW_PERCENT / 100;
+}
+
+unsigned int HighLimit(unsigned int level)
+{
+	unsigned long limit = level + (unsigned long)level * WINDOW_PERCENT / 100;
+	return (limit > 65535) ? 65535 : limit;
+}
+
+void setup()
+{
+	// Configure Arduino's built in LED as output
+	pinMode(LED_BUILTIN, OUTPUT);
+
+	// Initialize serial port at 115200 bps
+	Serial.begin(115200);
+
+	// Initialize the I2C port
+	Wire.begin();
+
+	// Initialize AS7341L
+	boolean result = as7341L.begin();
+
+	// If the board did not properly initialize print an error message and halt the system
+	if(result == false)
+	{
+		PrintErrorMessage();
+		Serial.println("Check your connections. System halted !");
+		digitalWrite(LED_BUILTIN, LOW); 
+		while (true) ;
+	}
+	
+	// Bring AS7341L to the powered up state
+	as7341L.enable_AS7341X();
+
+	// Use a gain that leaves room above the current level
+	as7341L.setGain(AS7341X_GAIN::GAIN_X16);
+
+	// INT is open drain, so use the internal pull-up in case the board's pull-up is disconnected
+	pinMode(interruptPin, INPUT_PULLUP);
+	
+	// INT is active low
+	attachInterrupt(digitalPinToInterrupt(interruptPin), interruptServiceRoutine, FALLING);
+	
+	// If the board was properly initialized, turn on LED_BUILTIN
+	if(result == true)
+	  digitalWrite(LED_BUILTIN, HIGH);
+
+	// Take a reference reading to center the window on
+	unsigned int channelReadings[12] = { 0 };
+	if (as7341L.readAllChannels(channelReadings) == false)
+	{
+		PrintErrorMessage();
+		while (true) ;
+	}
+	unsigned int level = channelReadings[MONITORED_INDEX];
+	Serial.print("F7 reference level: ");
+	Serial.println(level);
+
+	// Two cycles out of the window trigger an event
+	if (as7341L.startThresholdMonitoring(MONITORED_CHANNEL, LowLimit(level), HighLimit(level), 2, 100) == false)
+	{
+		PrintErrorMessage();
+		while (true) ;
+	}
+}
+
+void loop()
+{
+	// Returns right away without touching the bus unless INT fired
+	if (as7341L.updateThresholdMonitoring())
+	{
+		AS7341X_SAMPLE sample;
+		AS7341X_THRESHOLD_EVENT event = as7341L.getThresholdEvent(sample);
+		
+		Serial.println("---------------------------------");
+		Serial.print("Event ");
+		Serial.print(as7341L.getThresholdEventCount());
+		if (event == AS7341X_THRESHOLD_EVENT::ABOVE)
+			Serial.println(": F7 went above the window");
+		else
+			Serial.println(": F7 went below the window");
+		Serial.println();
+		Serial.print("F1 (415 nm): ");
+		Serial.println(sample.channels[0]);
+		Serial.print("F2 (445 nm): ");
+		Serial.println(sample.channels[1]);
+		Serial.print("F3 (480 nm): ");
+		Serial.println(sample.channels[2]);
+		Serial.print("F4 (515 nm): ");
+		Serial.println(sample.channels[3]);
+		Serial.print("F5 (555 nm): ");
+		Serial.println(sample.channels[6]);
+		Serial.print("F6 (590 nm): ");
+		Serial.println(sample.channels[7]);
+		Serial.print("F7 (630 nm): ");
+		Serial.println(sample.channels[8]);
+		Serial.print("F8 (680 nm): ");
+		Serial.println(sample.channels[9]);
+		Serial.print("Clear: ");
+		Serial.println(sample.channels[10]);
+		Serial.print("NIR: ");
+		Serial.println(sample.channels[11]);
+		Serial.println();
+
+		// Follow the new level so only the next change is reported
+		unsigned int level = sample.channels[MONITORED_INDEX];
+		as7341L.setLowThreshold(LowLimit(level));
+		as7341L.setHighThreshold(HighLimit(level));
+	}
+
+	// The MCU could sleep here until INT fires
+}
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""
+Host side decoder for the AS7341X binary frame stream (SparkFun_AS7341X_FrameEncoder).
+
+Reads frames from a capture file or a serial port and prints one CSV line per sample:
+
+    python3 decode_frames.py capture.bin > samples.csv
+    python3 decode_frames.py --port /dev/ttyUSB0 --baud 921600 > samples.csv   (needs pyserial)
+
+The frame layout is described in src/SparkFun_AS7341X_Frame.h.
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+VERSION = 1
+FRAME_KEY = 0
+FRAME_DELTA = 1
+MAX_PAYLOAD = 41 - 6
+SINGLE_PASS = 0x04
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def varint(payload, pos):
+    value = 0
+    shift = 0
+    while True:
+        b = payload[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+def channel_count(flags):
+    return 6 if flags & SINGLE_PASS else 12
+
+
+class Decoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.previous = None
+        self.errors = 0
+
+    def feed(self, data):
+        """Adds received bytes, yields every sample completed by them as a dict"""
+        self.buffer += data
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                del self.buffer[:-1]
+                return
+            del self.buffer[:start]
+            if len(self.buffer) < 4:
+                return
+            header, length = self.buffer[2], self.buffer[3]
+            if header >> 4 != VERSION or length > MAX_PAYLOAD:
+                self.errors += 1
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < 6 + length:
+                return
+            frame = bytes(self.buffer[:6 + length])
+            crc = struct.unpack_from("<H", frame, 4 + length)[0]
+            if crc16(frame[2:4 + length]) != crc:
+                self.errors += 1
+                del self.buffer[:1]
+                continue
+            del self.buffer[:6 + length]
+            sample = self.decode(header & 0x0F, frame[4:4 + length])
+            if sample is None:
+                self.errors += 1
+            else:
+                yield sample
+
+    def decode(self, kind, payload):
+        sequence = struct.unpack_from("<H", payload)[0]
+        if kind == FRAME_KEY:
+            timestamp, atime, astep, gain, flags = struct.unpack_from("<IBHBB", payload, 2)
+            count = channel_count(flags)
+            channels = list(struct.unpack_from("<%dH" % count, payload, 11))
+        elif kind == FRAME_DELTA:
+            previous = self.previous
+            if previous is None or sequence != (previous["sequence"] + 1) & 0xFFFF:
+                self.previous = None
+                return None
+            step, pos = varint(payload, 2)
+            timestamp = (previous["timestamp"] + step) & 0xFFFFFFFF
+            atime, astep, gain = previous["atime"], previous["astep"], previous["gain"]
+            flags = payload[pos]
+            pos += 1
+            channels = []
+            for value in previous["channels"][:channel_count(flags)]:
+                step, pos = varint(payload, pos)
+                channels.append(value + ((-(step + 1) >> 1) if step & 1 else step >> 1))
+        else:
+            return None
+
+        self.previous = dict(sequence=sequence, timestamp=timestamp, atime=atime, astep=astep,
+                             gain=gain, flags=flags, channels=channels)
+        return self.previous
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("file", nargs="?", help="capture file (default: standard input)")
+    parser.add_argument("--port", help="serial port to read from instead of a file")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        source = serial.Serial(args.port, args.baud, timeout=1)
+    elif args.file:
+        source = open(args.file, "rb")
+    else:
+        source = sys.stdin.buffer
+
+    decoder = Decoder()
+    print("sequence,timestamp_us,atime,astep,gain_low,gain_high,flags," +
+          ",".join("ch%d" % i for i in range(12)))
+    try:
+        while True:
+            data = source.read(256)
+            if not data:
+                if args.port:
+                    continue
+                break
+            for s in decoder.feed(data):
+                channels = s["channels"] + [""] * (12 - len(s["channels"]))
+                print(",".join(str(v) for v in [s["sequence"], s["timestamp"], s["atime"], s["astep"],
+                                                s["gain"] & 0x0F, s["gain"] >> 4, s["flags"]] + channels))
+    except KeyboardInterrupt:
+        pass
+
+    if decoder.errors:
+        print("%d frames dropped" % decoder.errors, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
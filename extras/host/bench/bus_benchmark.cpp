@@ -0,0 +1,282 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file measures the I2C cost of the main library calls on the simulated board and checks it against a budget.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Usage: bus_benchmark [budget.json]
+//
+// Runs every call once at 100 kHz, 400 kHz and 1 MHz and prints a JSON report to stdout. Per call it gives the
+// transactions and bytes on the bus (address bytes and PCA9536 traffic included), the library's bank switches, the
+// bus time and the time the call took on the virtual clock (measurement waits included), both in microseconds.
+// With a budget file, which has the same layout as the report, any value over its budget or without a budget is
+// listed on stderr and the exit code is 1. Copying a report gives a budget with no headroom.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <map>
+#include <string>
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+#include "SparkFun_AS7341X_Simulator.h"
+#include "SparkFun_PCA9536_Simulator.h"
+
+#if !AS7341X_IO_STATS
+#error "The benchmark must be linked against a library built with AS7341X_IO_STATS=1"
+#endif
+
+// Scratch buffers for the calls under test
+static unsigned int rawReadings[12];
+static float basicCountReadings[12];
+
+struct Benchmark
+{
+	const char* name;
+	void (*run)(SparkFun_AS7341X& as7341);
+};
+
+static const Benchmark benchmarks[] =
+{
+	{ "begin", [](SparkFun_AS7341X& as7341) { as7341.begin(); } },
+	{ "readAllChannels", [](SparkFun_AS7341X& as7341) { as7341.readAllChannels(rawReadings); } },
+	{ "readAllChannelsBasicCounts", [](SparkFun_AS7341X& as7341) { as7341.readAllChannelsBasicCounts(basicCountReadings); } },
+	{ "read415nm", [](SparkFun_AS7341X& as7341) { as7341.read415nm(); } },
+	{ "read445nm", [](SparkFun_AS7341X& as7341) { as7341.read445nm(); } },
+	{ "read480nm", [](SparkFun_AS7341X& as7341) { as7341.read480nm(); } },
+	{ "read515nm", [](SparkFun_AS7341X& as7341) { as7341.read515nm(); } },
+	{ "read555nm", [](SparkFun_AS7341X& as7341) { as7341.read555nm(); } },
+	{ "read590nm", [](SparkFun_AS7341X& as7341) { as7341.read590nm(); } },
+	{ "read630nm", [](SparkFun_AS7341X& as7341) { as7341.read630nm(); } },
+	{ "read680nm", [](SparkFun_AS7341X& as7341) { as7341.read680nm(); } },
+	{ "readClear", [](SparkFun_AS7341X& as7341) { as7341.readClear(); } },
+	{ "readNIR", [](SparkFun_AS7341X& as7341) { as7341.readNIR(); } },
+	{ "readBasicCount415nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount415nm(); } },
+	{ "readBasicCount445nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount445nm(); } },
+	{ "readBasicCount480nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount480nm(); } },
+	{ "readBasicCount515nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount515nm(); } },
+	{ "readBasicCount555nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount555nm(); } },
+	{ "readBasicCount590nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount590nm(); } },
+	{ "readBasicCount630nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount630nm(); } },
+	{ "readBasicCount680nm", [](SparkFun_AS7341X& as7341) { as7341.readBasicCount680nm(); } },
+	{ "readBasicCountClear", [](SparkFun_AS7341X& as7341) { as7341.readBasicCountClear(); } },
+	{ "readBasicCountNIR", [](SparkFun_AS7341X& as7341) { as7341.readBasicCountNIR(); } },
+	{ "getFlickerFrequency", [](SparkFun_AS7341X& as7341) { as7341.getFlickerFrequency(); } },
+};
+
+// Bus clocks and their report keys
+struct BusClock
+{
+	unsigned long hz;
+	const char* name;
+};
+
+static const BusClock busClocks[] =
+{
+	{ 100000, "100k" },
+	{ 400000, "400k" },
+	{ 1000000, "1m" },
+};
+
+// Report fields of one call, in output order
+const uint8_t FIELD_COUNT = 5;
+static const char* fieldNames[FIELD_COUNT] = { "transactions", "bytes", "bank_switches", "bus_us", "time_us" };
+
+// Flattened budget: "clocks.100k.readAllChannels.transactions" -> limit
+typedef std::map<std::string, double> Budget;
+
+// Minimal JSON reader for the budget file: nested objects with number leaves, anything else is an error
+class BudgetReader
+{
+private:
+	const char* _cursor;
+	Budget& _budget;
+
+	void skipSpace()
+	{
+		while (isspace((unsigned char)*_cursor))
+			_cursor++;
+	}
+
+	bool expect(char c)
+	{
+		skipSpace();
+		if (*_cursor != c)
+			return false;
+		_cursor++;
+		return true;
+	}
+
+	bool readString(std::string& text)
+	{
+		if (!expect('"'))
+			return false;
+		text.clear();
+		while (*_cursor && *_cursor != '"')
+			text += *_cursor++;
+		return expect('"');
+	}
+
+	bool readValue(const std::string& key)
+	{
+		skipSpace();
+		if (*_cursor == '{')
+			return readObject(key);
+
+		char* end;
+		double value = strtod(_cursor, &end);
+		if (end == _cursor)
+			return false;
+		_cursor = end;
+		_budget[key] = value;
+		return true;
+	}
+
+	bool readObject(const std::string& prefix)
+	{
+		if (!expect('{'))
+			return false;
+		if (expect('}'))
+			return true;
+
+		do
+		{
+			std::string name;
+			if (!readString(name) || !expect(':'))
+				return false;
+			if (!readValue(prefix.empty() ? name : prefix + "." + name))
+				return false;
+		} while (expect(','));
+
+		return expect('}');
+	}
+
+public:
+	BudgetReader(const char* text, Budget& budget) : _cursor(text), _budget(budget) {}
+
+	bool read()
+	{
+		if (!readObject(""))
+			return false;
+		skipSpace();
+		return *_cursor == '\0';
+	}
+};
+
+static bool loadBudget(const char* path, Budget& budget)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr)
+		return false;
+
+	std::string text;
+	char chunk[512];
+	size_t length;
+	while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		text.append(chunk, length);
+	fclose(file);
+
+	return BudgetReader(text.c_str(), budget).read();
+}
+
+// Runs one call and fills values in fieldNames order
+static void runBenchmark(const Benchmark& benchmark, SparkFun_AS7341X& as7341, unsigned long values[FIELD_COUNT])
+{
+	Wire.resetStats();
+	as7341.resetIOStats();
+	uint64_t start = hostNanos();
+	benchmark.run(as7341);
+	uint64_t elapsed = hostNanos() - start;
+
+	HostI2CStats bus;
+	Wire.getStats(bus);
+	SparkFun_AS7341X_IOStats library;
+	as7341.getIOStats(library);
+
+	values[0] = bus.transactions;
+	values[1] = bus.bytes;
+	values[2] = library.bankSwitches;
+	values[3] = (unsigned long)(bus.busNanos / 1000);
+	values[4] = (unsigned long)(elapsed / 1000);
+}
+
+int main(int argc, char** argv)
+{
+	Budget budget;
+	bool checkBudget = argc > 1;
+	if (checkBudget && !loadBudget(argv[1], budget))
+	{
+		fprintf(stderr, "cannot read budget file %s\n", argv[1]);
+		return 2;
+	}
+
+	unsigned int overBudget = 0;
+	printf("{\n\t\"clocks\": {\n");
+	for (size_t c = 0; c < sizeof(busClocks) / sizeof(busClocks[0]); c++)
+	{
+		// Same scene and a freshly powered board for every clock, so the runs only differ by bus speed
+		hostResetClock();
+		Wire.setClock(busClocks[c].hz);
+		SparkFun_AS7341X_Simulator sensor;
+		SparkFun_PCA9536_Simulator gpio;
+		Wire.attach(DEFAULT_AS7341X_ADDR, sensor);
+		Wire.attach(0x41, gpio);
+		sensor.attachGpioExpander(gpio);
+		for (uint8_t i = 0; i < 10; i++)
+			sensor.setAmbient(i, 0.05f * (i + 1));
+		sensor.setAmbient(10, 0.01f);
+		sensor.setFlicker(100);
+
+		// The flicker engine is only on the AS7341
+		SparkFun_AS7341X as7341(AS7341X_DEVICE::AS7341);
+
+		printf("\t\t\"%s\": {\n", busClocks[c].name);
+		for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++)
+		{
+			unsigned long values[FIELD_COUNT];
+			runBenchmark(benchmarks[b], as7341, values);
+
+			printf("\t\t\t\"%s\": { ", benchmarks[b].name);
+			for (uint8_t f = 0; f < FIELD_COUNT; f++)
+			{
+				printf("%s\"%s\": %lu", f ? ", " : "", fieldNames[f], values[f]);
+				if (!checkBudget)
+					continue;
+
+				std::string key = std::string("clocks.") + busClocks[c].name + "." + benchmarks[b].name + "." + fieldNames[f];
+				Budget::const_iterator limit = budget.find(key);
+				if (limit == budget.end())
+				{
+					fprintf(stderr, "no budget for %s\n", key.c_str());
+					overBudget++;
+				}
+				else if (values[f] > limit->second)
+				{
+					fprintf(stderr, "over budget: %s is %lu, budget %g\n", key.c_str(), values[f], limit->second);
+					overBudget++;
+				}
+			}
+			printf(" }%s\n", (b + 1 < sizeof(benchmarks) / sizeof(benchmarks[0])) ? "," : "");
+		}
+		printf("\t\t}%s\n", (c + 1 < sizeof(busClocks) / sizeof(busClocks[0])) ? "," : "");
+
+		Wire.detach(DEFAULT_AS7341X_ADDR);
+		Wire.detach(0x41);
+	}
+	printf("\t},\n\t\"over_budget\": %u\n}\n", overBudget);
+
+	return (overBudget == 0) ? 0 : 1;
+}
@@ -0,0 +1,312 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the virtual clock, pins and serial port of the host Arduino core.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+HardwareSerial Serial;
+
+static uint64_t clockNanos = 0;
+static uint32_t callCostNanos = 1000;
+
+// Function local so that simulated devices constructed as globals in other files can register
+static std::vector<HostClockListener*>& clockListeners()
+{
+	static std::vector<HostClockListener*> listeners;
+	return listeners;
+}
+
+// Host pins, their interrupt handlers and whether interrupts are masked
+const uint8_t HOST_PIN_COUNT = 64;
+static uint8_t pinLevel[HOST_PIN_COUNT];
+static void (*pinIsr[HOST_PIN_COUNT])();
+static int pinIsrMode[HOST_PIN_COUNT];
+static bool interruptsMasked = false;
+static uint8_t pendingIsr[HOST_PIN_COUNT];
+
+uint64_t hostNanos()
+{
+	return clockNanos;
+}
+
+void hostAdvanceNanos(uint64_t nanos)
+{
+	clockNanos += nanos;
+	std::vector<HostClockListener*>& listeners = clockListeners();
+	for (size_t i = 0; i < listeners.size(); i++)
+		listeners[i]->onClock(clockNanos);
+}
+
+void hostSetCallCost(uint32_t nanos)
+{
+	callCostNanos = nanos;
+}
+
+void hostResetClock()
+{
+	clockNanos = 0;
+}
+
+void hostAddClockListener(HostClockListener* listener)
+{
+	clockListeners().push_back(listener);
+}
+
+void hostRemoveClockListener(HostClockListener* listener)
+{
+	std::vector<HostClockListener*>& listeners = clockListeners();
+	listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+unsigned long millis()
+{
+	hostAdvanceNanos(callCostNanos);
+	return (unsigned long)(clockNanos / 1000000);
+}
+
+unsigned long micros()
+{
+	hostAdvanceNanos(callCostNanos);
+	return (unsigned long)(clockNanos / 1000);
+}
+
+void delay(unsigned long ms)
+{
+	hostAdvanceNanos(uint64_t(ms) * 1000000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	hostAdvanceNanos(uint64_t(us) * 1000);
+}
+
+void yield()
+{
+	hostAdvanceNanos(callCostNanos);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	if (pin < HOST_PIN_COUNT && mode == INPUT_PULLUP)
+		pinLevel[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin < HOST_PIN_COUNT)
+		pinLevel[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+	return (pin < HOST_PIN_COUNT) ? pinLevel[pin] : LOW;
+}
+
+int digitalPinToInterrupt(uint8_t pin)
+{
+	return pin;
+}
+
+void attachInterrupt(int interrupt, void (*isr)(), int mode)
+{
+	if (interrupt < 0 || interrupt >= HOST_PIN_COUNT)
+		return;
+	pinIsr[interrupt] = isr;
+	pinIsrMode[interrupt] = mode;
+	pendingIsr[interrupt] = 0;
+}
+
+void detachInterrupt(int interrupt)
+{
+	if (interrupt >= 0 && interrupt < HOST_PIN_COUNT)
+		pinIsr[interrupt] = nullptr;
+}
+
+void noInterrupts()
+{
+	interruptsMasked = true;
+}
+
+void interrupts()
+{
+	interruptsMasked = false;
+
+	// Edges seen while masked are serviced as soon as interrupts are enabled again, like a pending flag would
+	for (uint8_t pin = 0; pin < HOST_PIN_COUNT; pin++)
+	{
+		if (pendingIsr[pin] && pinIsr[pin])
+		{
+			pendingIsr[pin] = 0;
+			pinIsr[pin]();
+		}
+	}
+}
+
+void hostSetPinLevel(uint8_t pin, uint8_t level)
+{
+	if (pin >= HOST_PIN_COUNT)
+		return;
+
+	uint8_t previous = pinLevel[pin];
+	level = level ? HIGH : LOW;
+	pinLevel[pin] = level;
+	if (previous == level || !pinIsr[pin])
+		return;
+
+	int mode = pinIsrMode[pin];
+	bool fire = (mode == CHANGE) || (mode == FALLING && level == LOW) || (mode == RISING && level == HIGH);
+	if (!fire)
+		return;
+
+	if (interruptsMasked)
+		pendingIsr[pin] = 1;
+	else
+		pinIsr[pin]();
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+	size_t written = 0;
+	for (size_t i = 0; i < size; i++)
+		written += write(buffer[i]);
+	return written;
+}
+
+size_t Print::write(const char* text)
+{
+	return write((const uint8_t*)text, strlen(text));
+}
+
+size_t Print::printNumber(unsigned long value, int base)
+{
+	char buffer[8 * sizeof(long) + 1];
+	char* cursor = &buffer[sizeof(buffer) - 1];
+	*cursor = '\0';
+	if (base < 2)
+		base = 10;
+
+	do
+	{
+		int digit = value % base;
+		value /= base;
+		*--cursor = digit < 10 ? '0' + digit : 'A' + digit - 10;
+	} while (value);
+
+	return write(cursor);
+}
+
+size_t Print::print(const char* text)
+{
+	return write(text);
+}
+
+size_t Print::print(char value)
+{
+	return write(uint8_t(value));
+}
+
+size_t Print::print(int value, int base)
+{
+	return print(long(value), base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+	return printNumber(value, base);
+}
+
+size_t Print::print(long value, int base)
+{
+	if (base == DEC && value < 0)
+		return write(uint8_t('-')) + printNumber(0UL - (unsigned long)value, base);
+	return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+	return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+	char buffer[48];
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+	return write(buffer);
+}
+
+size_t Print::println()
+{
+	return write("\r\n");
+}
+
+size_t Print::println(const char* text)
+{
+	return print(text) + println();
+}
+
+size_t Print::println(char value)
+{
+	return print(value) + println();
+}
+
+size_t Print::println(int value, int base)
+{
+	return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base)
+{
+	return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base)
+{
+	return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base)
+{
+	return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits)
+{
+	return print(value, digits) + println();
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+	(void)baud;
+}
+
+void HardwareSerial::flush()
+{
+	fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+	return fwrite(&value, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+	return fwrite(buffer, 1, size, stdout);
+}
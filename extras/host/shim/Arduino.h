@@ -0,0 +1,163 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the subset of the Arduino core the library needs to build and run on a Linux host.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_HOST_ARDUINO__
+#define __SparkFun_AS7341X_HOST_ARDUINO__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Flash and RAM are the same thing on the host
+#define PROGMEM
+#define F(string) (string)
+#define memcpy_P memcpy
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_float(address) (*(const float*)(address))
+
+#define LOW 0
+#define HIGH 1
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define LED_BUILTIN 13
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// Virtual time. Nothing runs in real time: the clock only moves when the sketch waits, touches the bus or reads it.
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// Host pins. An interrupt fires when a simulated device drives its pin with hostSetPinLevel().
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(int interrupt, void (*isr)(), int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+
+// Something that needs to run whenever virtual time moves, a simulated device for example
+class HostClockListener
+{
+public:
+	virtual ~HostClockListener() {}
+
+	// Called with the virtual time, in nanoseconds, after every clock advance
+	virtual void onClock(uint64_t nowNanos) = 0;
+};
+
+// Current virtual time in nanoseconds
+uint64_t hostNanos();
+
+// Moves the virtual clock forward and notifies the listeners
+void hostAdvanceNanos(uint64_t nanos);
+
+// Time every millis() or micros() call costs, in nanoseconds, so that polling loops always make progress. 1000 by default.
+void hostSetCallCost(uint32_t nanos);
+
+// Resets the virtual clock to 0. Listeners are kept.
+void hostResetClock();
+
+void hostAddClockListener(HostClockListener* listener);
+void hostRemoveClockListener(HostClockListener* listener);
+
+// Drives a host input pin from a simulated device, firing an attached interrupt on a matching edge
+void hostSetPinLevel(uint8_t pin, uint8_t level);
+
+class Print
+{
+public:
+	virtual ~Print() {}
+
+	virtual size_t write(uint8_t value) = 0;
+	virtual size_t write(const uint8_t* buffer, size_t size);
+	size_t write(const char* text);
+
+	size_t print(const char* text);
+	size_t print(char value);
+	size_t print(int value, int base = DEC);
+	size_t print(unsigned int value, int base = DEC);
+	size_t print(long value, int base = DEC);
+	size_t print(unsigned long value, int base = DEC);
+	size_t print(double value, int digits = 2);
+
+	size_t println();
+	size_t println(const char* text);
+	size_t println(char value);
+	size_t println(int value, int base = DEC);
+	size_t println(unsigned int value, int base = DEC);
+	size_t println(long value, int base = DEC);
+	size_t println(unsigned long value, int base = DEC);
+	size_t println(double value, int digits = 2);
+
+private:
+	size_t printNumber(unsigned long value, int base);
+};
+
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() { return -1; }
+};
+
+// Writes to stdout, never has anything to read
+class HardwareSerial : public Stream
+{
+public:
+	void begin(unsigned long baud);
+	void end() {}
+	void flush();
+	operator bool() { return true; }
+
+	size_t write(uint8_t value) override;
+	size_t write(const uint8_t* buffer, size_t size) override;
+	using Print::write;
+
+	int available() override { return 0; }
+	int read() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // ! __SparkFun_AS7341X_HOST_ARDUINO__
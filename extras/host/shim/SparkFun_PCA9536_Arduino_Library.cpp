@@ -0,0 +1,117 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines a host stand-in for the SparkFun PCA9536 library with the same API and the same bus traffic.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <SparkFun_PCA9536_Arduino_Library.h>
+
+bool PCA9536::begin(TwoWire& wirePort)
+{
+	_i2cPort = &wirePort;
+	return isConnected();
+}
+
+bool PCA9536::isConnected()
+{
+	_i2cPort->beginTransmission(PCA9536_ADDRESS);
+	return _i2cPort->endTransmission() == 0;
+}
+
+PCA9536_error_t PCA9536::readRegister(PCA9536_REGISTER_t registerAddress, uint8_t& value)
+{
+	_i2cPort->beginTransmission(PCA9536_ADDRESS);
+	_i2cPort->write(uint8_t(registerAddress));
+	if (_i2cPort->endTransmission(false) != 0)
+		return PCA9536_ERROR_READ;
+
+	if (_i2cPort->requestFrom(PCA9536_ADDRESS, uint8_t(1)) != 1)
+		return PCA9536_ERROR_READ;
+
+	value = _i2cPort->read();
+	return PCA9536_ERROR_SUCCESS;
+}
+
+PCA9536_error_t PCA9536::writeRegister(PCA9536_REGISTER_t registerAddress, uint8_t value)
+{
+	_i2cPort->beginTransmission(PCA9536_ADDRESS);
+	_i2cPort->write(uint8_t(registerAddress));
+	_i2cPort->write(value);
+	if (_i2cPort->endTransmission() != 0)
+		return PCA9536_ERROR_WRITE;
+	return PCA9536_ERROR_SUCCESS;
+}
+
+PCA9536_error_t PCA9536::updateBit(PCA9536_REGISTER_t registerAddress, uint8_t pin, bool set)
+{
+	if (pin > 3)
+		return PCA9536_ERROR_UNDEFINED;
+
+	uint8_t value;
+	PCA9536_error_t error = readRegister(registerAddress, value);
+	if (error != PCA9536_ERROR_SUCCESS)
+		return error;
+
+	if (set)
+		value |= (1 << pin);
+	else
+		value &= ~(1 << pin);
+	return writeRegister(registerAddress, value);
+}
+
+PCA9536_error_t PCA9536::pinMode(uint8_t pin, uint8_t mode)
+{
+	// Configuration bits are 1 for inputs
+	return updateBit(PCA9536_REGISTER_CONFIGURATION, pin, mode != OUTPUT);
+}
+
+PCA9536_error_t PCA9536::write(uint8_t pin, uint8_t value)
+{
+	return updateBit(PCA9536_REGISTER_OUTPUT_PORT, pin, value != LOW);
+}
+
+PCA9536_error_t PCA9536::digitalWrite(uint8_t pin, uint8_t value)
+{
+	return write(pin, value);
+}
+
+uint8_t PCA9536::readReg()
+{
+	uint8_t value = 0;
+	readRegister(PCA9536_REGISTER_INPUT_PORT, value);
+	return value & 0x0f;
+}
+
+uint8_t PCA9536::read(uint8_t pin)
+{
+	if (pin > 3)
+		return 0;
+	return (readReg() >> pin) & 0x01;
+}
+
+uint8_t PCA9536::digitalRead(uint8_t pin)
+{
+	return read(pin);
+}
+
+PCA9536_error_t PCA9536::invert(uint8_t pin, PCA9536_invert_t inversion)
+{
+	return updateBit(PCA9536_REGISTER_POLARITY_INVERSION, pin, inversion == PCA9536_INVERT);
+}
+
+PCA9536_error_t PCA9536::revert(uint8_t pin)
+{
+	return invert(pin, PCA9536_RETAIN);
+}
@@ -0,0 +1,74 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares a host stand-in for the SparkFun PCA9536 library with the same API and the same bus traffic.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_HOST_PCA9536__
+#define __SparkFun_AS7341X_HOST_PCA9536__
+
+#include <Arduino.h>
+#include <Wire.h>
+
+const uint8_t PCA9536_ADDRESS = 0x41;
+
+typedef enum
+{
+	PCA9536_ERROR_READ = -4,
+	PCA9536_ERROR_WRITE = -3,
+	PCA9536_ERROR_INVALID_ADDRESS = -2,
+	PCA9536_ERROR_UNDEFINED = -1,
+	PCA9536_ERROR_SUCCESS = 1
+} PCA9536_error_t;
+
+typedef enum
+{
+	PCA9536_REGISTER_INPUT_PORT = 0x00,
+	PCA9536_REGISTER_OUTPUT_PORT = 0x01,
+	PCA9536_REGISTER_POLARITY_INVERSION = 0x02,
+	PCA9536_REGISTER_CONFIGURATION = 0x03
+} PCA9536_REGISTER_t;
+
+typedef enum
+{
+	PCA9536_RETAIN,
+	PCA9536_INVERT
+} PCA9536_invert_t;
+
+// Every pin access is a read-modify-write of the matching register, like the Arduino library does
+class PCA9536
+{
+private:
+	TwoWire* _i2cPort = &Wire;
+
+	PCA9536_error_t readRegister(PCA9536_REGISTER_t registerAddress, uint8_t& value);
+	PCA9536_error_t writeRegister(PCA9536_REGISTER_t registerAddress, uint8_t value);
+	PCA9536_error_t updateBit(PCA9536_REGISTER_t registerAddress, uint8_t pin, bool set);
+
+public:
+	bool begin(TwoWire& wirePort = Wire);
+	bool isConnected();
+
+	PCA9536_error_t pinMode(uint8_t pin, uint8_t mode);
+	PCA9536_error_t write(uint8_t pin, uint8_t value);
+	PCA9536_error_t digitalWrite(uint8_t pin, uint8_t value);
+	uint8_t readReg();
+	uint8_t read(uint8_t pin);
+	uint8_t digitalRead(uint8_t pin);
+	PCA9536_error_t invert(uint8_t pin, PCA9536_invert_t inversion = PCA9536_INVERT);
+	PCA9536_error_t revert(uint8_t pin);
+};
+
+#endif // ! __SparkFun_AS7341X_HOST_PCA9536__
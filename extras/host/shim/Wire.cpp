@@ -0,0 +1,159 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the host TwoWire, a simulated I2C bus with transaction counters and a bit time model.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Wire.h>
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+{
+	resetStats();
+}
+
+HostI2CDevice* TwoWire::find(uint8_t address)
+{
+	for (byte i = 0; i < _deviceCount; i++)
+		if (_devices[i].address == address)
+			return _devices[i].device;
+	return nullptr;
+}
+
+bool TwoWire::attach(uint8_t address, HostI2CDevice& device)
+{
+	if (find(address) || _deviceCount == sizeof(_devices) / sizeof(_devices[0]))
+		return false;
+
+	_devices[_deviceCount].address = address;
+	_devices[_deviceCount].device = &device;
+	_deviceCount++;
+	return true;
+}
+
+void TwoWire::detach(uint8_t address)
+{
+	for (byte i = 0; i < _deviceCount; i++)
+	{
+		if (_devices[i].address != address)
+			continue;
+		_devices[i] = _devices[--_deviceCount];
+		return;
+	}
+}
+
+void TwoWire::setClock(uint32_t frequency)
+{
+	if (frequency > 0)
+		_clock = frequency;
+}
+
+void TwoWire::transfer(size_t byteCount, bool acknowledged)
+{
+	// START, 9 clocks per byte (8 data bits and ACK) and STOP. A NACKed address ends the transaction after one byte.
+	if (!acknowledged)
+		byteCount = 1;
+	uint64_t bits = 2 + 9 * uint64_t(byteCount);
+	uint64_t nanos = (bits * 1000000000ULL + _clock - 1) / _clock;
+
+	_stats.transactions++;
+	_stats.bytes += byteCount;
+	_stats.busNanos += nanos;
+	if (!acknowledged)
+		_stats.nacks++;
+
+	hostAdvanceNanos(nanos);
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+	_txAddress = address;
+	_txLength = 0;
+	_transmitting = true;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+	(void)sendStop;
+	_transmitting = false;
+
+	HostI2CDevice* device = find(_txAddress);
+	transfer(_txLength + 1, device != nullptr);
+	if (!device)
+		return 2;
+
+	device->i2cWrite(_txBuffer, _txLength);
+	return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop)
+{
+	(void)sendStop;
+	if (quantity > BUFFER_LENGTH)
+		quantity = BUFFER_LENGTH;
+
+	_rxIndex = 0;
+	_rxLength = 0;
+
+	HostI2CDevice* device = find(address);
+	transfer(quantity + 1, device != nullptr);
+	if (!device)
+		return 0;
+
+	device->i2cRead(_rxBuffer, quantity);
+	_rxLength = quantity;
+	return quantity;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+	if (!_transmitting || _txLength >= BUFFER_LENGTH)
+		return 0;
+	_txBuffer[_txLength++] = value;
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t* buffer, size_t size)
+{
+	size_t written = 0;
+	for (size_t i = 0; i < size; i++)
+		written += write(buffer[i]);
+	return written;
+}
+
+int TwoWire::available()
+{
+	return _rxLength - _rxIndex;
+}
+
+int TwoWire::read()
+{
+	if (_rxIndex >= _rxLength)
+		return -1;
+	return _rxBuffer[_rxIndex++];
+}
+
+int TwoWire::peek()
+{
+	if (_rxIndex >= _rxLength)
+		return -1;
+	return _rxBuffer[_rxIndex];
+}
+
+void TwoWire::resetStats()
+{
+	memset(&_stats, 0, sizeof(_stats));
+}
@@ -0,0 +1,121 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the host TwoWire, a simulated I2C bus with transaction counters and a bit time model.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_HOST_WIRE__
+#define __SparkFun_AS7341X_HOST_WIRE__
+
+#include <Arduino.h>
+
+// Same buffer size as the AVR Wire library: longer writes are truncated and longer reads are capped
+#define BUFFER_LENGTH 32
+
+// A device on the simulated bus. Each call is one transaction, addressed and acknowledged.
+class HostI2CDevice
+{
+public:
+	virtual ~HostI2CDevice() {}
+
+	// Receives the bytes of a write transaction
+	virtual void i2cWrite(const uint8_t* data, size_t length) = 0;
+
+	// Fills buffer for a read transaction
+	virtual void i2cRead(uint8_t* buffer, size_t length) = 0;
+};
+
+// Traffic seen on a bus
+struct HostI2CStats
+{
+	// Write and read transactions, each from START to STOP (or repeated START)
+	uint32_t transactions;
+
+	// Bytes on the wire, address bytes included
+	uint32_t bytes;
+
+	// Transactions nobody acknowledged
+	uint32_t nacks;
+
+	// Time the bus was busy, in nanoseconds
+	uint64_t busNanos;
+};
+
+class TwoWire : public Stream
+{
+private:
+	struct Attachment
+	{
+		uint8_t address;
+		HostI2CDevice* device;
+	};
+
+	Attachment _devices[8];
+	byte _deviceCount = 0;
+
+	uint32_t _clock = 100000;
+
+	uint8_t _txAddress = 0;
+	uint8_t _txBuffer[BUFFER_LENGTH];
+	uint8_t _txLength = 0;
+	bool _transmitting = false;
+
+	uint8_t _rxBuffer[BUFFER_LENGTH];
+	uint8_t _rxLength = 0;
+	uint8_t _rxIndex = 0;
+
+	HostI2CStats _stats;
+
+	HostI2CDevice* find(uint8_t address);
+
+	// Books one transaction of byteCount bytes (address included) and advances the virtual clock by its duration
+	void transfer(size_t byteCount, bool acknowledged);
+
+public:
+	TwoWire();
+
+	// Puts a simulated device on the bus at a 7 bit address
+	bool attach(uint8_t address, HostI2CDevice& device);
+	void detach(uint8_t address);
+
+	void begin() {}
+	void end() {}
+	void setClock(uint32_t frequency);
+	uint32_t getClock() { return _clock; }
+
+	void beginTransmission(uint8_t address);
+	void beginTransmission(int address) { beginTransmission(uint8_t(address)); }
+
+	// Returns 0 on success, 2 if the address was not acknowledged
+	uint8_t endTransmission(bool sendStop = true);
+
+	uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+	uint8_t requestFrom(int address, int quantity) { return requestFrom(uint8_t(address), uint8_t(quantity)); }
+
+	size_t write(uint8_t value) override;
+	size_t write(const uint8_t* buffer, size_t size) override;
+	using Print::write;
+
+	int available() override;
+	int read() override;
+	int peek() override;
+
+	void getStats(HostI2CStats& stats) { stats = _stats; }
+	void resetStats();
+};
+
+extern TwoWire Wire;
+
+#endif // ! __SparkFun_AS7341X_HOST_WIRE__
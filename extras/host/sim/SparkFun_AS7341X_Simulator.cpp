@@ -0,0 +1,659 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the register model of the AS7341 used by the host build.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_Simulator.h"
+
+// One integration step and one wait step
+const uint64_t STEP_NS = 2780;
+const uint64_t WAIT_STEP_NS = 2780000;
+
+const uint8_t FIFO_ENTRIES = 128;
+
+// Photodiode group behind each SMUX RAM nibble, (address << 1) | high nibble, -1 when unused. See AMS AN V1.1.
+static const int8_t nibblePhotodiode[40] =
+{
+	-1, 2,  0, -1,  -1, -1,  -1, 7,  5, -1,  1, 3,  -1, 4,  6, -1,  -1, 8,  -1, 4,
+	6, -1,  -1, -1,  -1, 1,  3, -1,  7, 5,  -1, 2,  0, -1,  -1, 8,  -1, -1,  9, 10
+};
+
+// Number of photodiodes in each group, the scene rate of a group is shared between them
+static const uint8_t photodiodeCount[SIM_PHOTODIODE_COUNT] = { 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1 };
+
+static float gainFactor(uint8_t code)
+{
+	if (code > 10)
+		code = 10;
+	return (code == 0) ? 0.5f : float(1UL << (code - 1));
+}
+
+SparkFun_AS7341X_Simulator::SparkFun_AS7341X_Simulator()
+{
+	for (uint8_t i = 0; i < SIM_PHOTODIODE_COUNT; i++)
+	{
+		_ambient[i] = 0;
+		_whiteLed[i] = 0;
+		_irLed[i] = 0;
+	}
+	reset();
+	hostAddClockListener(this);
+}
+
+SparkFun_AS7341X_Simulator::~SparkFun_AS7341X_Simulator()
+{
+	hostRemoveClockListener(this);
+}
+
+void SparkFun_AS7341X_Simulator::reset()
+{
+	memset(_registers, 0, sizeof(_registers));
+	memset(_bank1, 0, sizeof(_bank1));
+	memset(_smux, 0, sizeof(_smux));
+	memset(_data, 0, sizeof(_data));
+	memset(_latched, 0, sizeof(_latched));
+
+	// Power up values of the registers the library relies on
+	_registers[0x92] = 0x09 << 2;
+	_registers[0xaa] = 0x09;
+	_registers[0xaf] = 0x10;
+	_registers[0xb3] = 0xf2;
+	_registers[0xca] = 0xe7;
+	_registers[0xcb] = 0x03;
+	_registers[0xcf] = 0x09;
+
+	_pointer = 0;
+	_now = hostNanos();
+	_smuxBusy = false;
+	_running = false;
+	_saiAsleep = false;
+	_persistence = 0;
+	_dataStatus = 0;
+	_latchedStatus = 0;
+	_flickerRunning = false;
+	_flickerCount = 0;
+	_flickerSaturated = false;
+	_fifo.clear();
+	_bankViolations = 0;
+	_flickerViolations = 0;
+	_smuxCommands = 0;
+	_cycles = 0;
+	updateInterruptPin();
+}
+
+void SparkFun_AS7341X_Simulator::setAmbient(uint8_t photodiode, float rate)
+{
+	if (photodiode < SIM_PHOTODIODE_COUNT)
+		_ambient[photodiode] = rate;
+}
+
+void SparkFun_AS7341X_Simulator::setAmbient(float rate)
+{
+	for (uint8_t i = 0; i < SIM_PHOTODIODE_COUNT; i++)
+		_ambient[i] = rate;
+}
+
+void SparkFun_AS7341X_Simulator::setWhiteLed(uint8_t photodiode, float rate)
+{
+	if (photodiode < SIM_PHOTODIODE_COUNT)
+		_whiteLed[photodiode] = rate;
+}
+
+void SparkFun_AS7341X_Simulator::setIRLed(uint8_t photodiode, float rate)
+{
+	if (photodiode < SIM_PHOTODIODE_COUNT)
+		_irLed[photodiode] = rate;
+}
+
+void SparkFun_AS7341X_Simulator::setFlicker(float frequency, float depth)
+{
+	_flickerFrequency = frequency;
+	_flickerDepth = depth;
+}
+
+void SparkFun_AS7341X_Simulator::attachGpioExpander(SparkFun_PCA9536_Simulator& expander)
+{
+	_gpioExpander = &expander;
+}
+
+void SparkFun_AS7341X_Simulator::setInterruptPin(int pin)
+{
+	_interruptPin = pin;
+	if (pin >= 0)
+		hostSetPinLevel(pin, _interruptAsserted ? LOW : HIGH);
+}
+
+void SparkFun_AS7341X_Simulator::setGpioLevel(uint8_t level)
+{
+	_gpioLevel = level ? 1 : 0;
+}
+
+uint8_t SparkFun_AS7341X_Simulator::peekRegister(uint8_t address)
+{
+	if (address >= 0x60 && address <= 0x74)
+		return _bank1[address - 0x60];
+	return _registers[address];
+}
+
+void SparkFun_AS7341X_Simulator::onClock(uint64_t nowNanos)
+{
+	_now = nowNanos;
+	advance();
+}
+
+void SparkFun_AS7341X_Simulator::i2cWrite(const uint8_t* data, size_t length)
+{
+	_now = hostNanos();
+	advance();
+	if (length == 0)
+		return;
+
+	// Auto-increment, wrapping from FDATA_H back to FDATA_L
+	_pointer = data[0];
+	for (size_t i = 1; i < length; i++)
+	{
+		writeRegister(_pointer, data[i]);
+		_pointer = (_pointer == 0xff) ? 0xfe : _pointer + 1;
+	}
+}
+
+void SparkFun_AS7341X_Simulator::i2cRead(uint8_t* buffer, size_t length)
+{
+	_now = hostNanos();
+	advance();
+	for (size_t i = 0; i < length; i++)
+	{
+		buffer[i] = readRegister(_pointer);
+		_pointer = (_pointer == 0xff) ? 0xfe : _pointer + 1;
+	}
+}
+
+uint8_t* SparkFun_AS7341X_Simulator::locate(uint8_t address)
+{
+	bool bank1Selected = (_registers[0xa9] & 0x10) != 0;
+
+	// CFG_0 and the SMUX RAM are reachable from both banks
+	if (address == 0xa9 || address < 0x14)
+		return &_registers[address];
+
+	if (address >= 0x60 && address <= 0x74)
+	{
+		if (bank1Selected)
+			return &_bank1[address - 0x60];
+	}
+	else if (address >= 0x80 && !bank1Selected)
+		return &_registers[address];
+
+	_bankViolations++;
+	return nullptr;
+}
+
+uint8_t SparkFun_AS7341X_Simulator::readRegister(uint8_t address)
+{
+	uint8_t* location = locate(address);
+	if (!location)
+		return 0;
+
+	switch (address)
+	{
+	case 0x94:
+	case 0x95:
+		// Reading ASTATUS (or the first data byte) latches the whole result
+		memcpy(_latched, _data, sizeof(_latched));
+		_latchedStatus = _dataStatus;
+		_registers[0xa3] &= ~0x40;
+		if (address == 0x94)
+			return _latchedStatus;
+		return _latched[0];
+
+	case 0xbe:
+		// GPIO_IN follows the pin when the input is enabled
+		return (_registers[0xbe] & 0xfe) | (((_registers[0xbe] & 0x04) && _gpioLevel) ? 0x01 : 0x00);
+
+	case 0xfe:
+	case 0xff:
+	{
+		// FDATA_H pops the entry, a FIFO read clears FIFO_OV
+		_registers[0xa7] &= ~0x80;
+		if (_fifo.empty())
+			return 0;
+		uint16_t entry = _fifo.front();
+		if (address == 0xfe)
+			return entry & 0xff;
+		_fifo.pop_front();
+		updateFifoLevel();
+		return entry >> 8;
+	}
+
+	default:
+		break;
+	}
+
+	if (address > 0x95 && address <= 0xa0)
+		return _latched[address - 0x95];
+
+	return *location;
+}
+
+void SparkFun_AS7341X_Simulator::writeRegister(uint8_t address, uint8_t value)
+{
+	uint8_t* location = locate(address);
+	if (!location)
+		return;
+
+	switch (address)
+	{
+	case 0x80:
+		writeEnable(value);
+		return;
+
+	case 0x93:
+		// Write one to clear. Releasing the last enabled interrupt wakes a sensor asleep after the interrupt.
+		_registers[0x93] &= ~value;
+		if (value & 0x08)
+			_registers[0xa4] &= ~0x30;
+		if (_saiAsleep && !enabledInterruptAsserted())
+		{
+			_saiAsleep = false;
+			updateSpectralState(_now);
+		}
+		updateInterruptPin();
+		return;
+
+	case 0xdb:
+	{
+		// FD_STATUS valid and saturation flags clear when written with ones, the results go with their valid flags
+		uint8_t status = _registers[0xdb] & ~(value & 0x3c);
+		if ((status & 0x04) == 0)
+			status &= ~0x01;
+		if ((status & 0x08) == 0)
+			status &= ~0x02;
+		_registers[0xdb] = status;
+		return;
+	}
+
+	case 0xfa:
+		// CONTROL bits are commands and read back as 0
+		if (value & 0x01)
+		{
+			_saiAsleep = false;
+			updateSpectralState(_now);
+		}
+		if (value & 0x02)
+		{
+			_fifo.clear();
+			_registers[0xa7] &= ~0x80;
+			updateFifoLevel();
+		}
+		return;
+
+	case 0xf9:
+		*location = value;
+		updateInterruptPin();
+		return;
+
+	case 0xd7:
+	case 0xd8:
+	case 0xda:
+		// The flicker engine only takes a new configuration while FDEN is clear
+		if (_flickerRunning)
+		{
+			_flickerViolations++;
+			return;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// Identification, status, data and FIFO level registers are read only
+	bool readOnly = (address >= 0x90 && address <= 0xa8 && address != 0x93) || address == 0xfd || address >= 0xfe;
+	if (!readOnly)
+		*location = value;
+}
+
+void SparkFun_AS7341X_Simulator::writeEnable(uint8_t value)
+{
+	// SMUXEN can only be set, the device clears it when the command is done
+	bool smuxStart = (value & 0x10) && !(_registers[0x80] & 0x10);
+	_registers[0x80] = (value & ~0x10) | (_registers[0x80] & 0x10) | (smuxStart ? 0x10 : 0);
+
+	if (smuxStart && (value & 0x01))
+	{
+		_smuxBusy = true;
+		_smuxDoneAt = _now + SIM_SMUX_COMMAND_NS;
+	}
+
+	updateSpectralState(_now);
+}
+
+void SparkFun_AS7341X_Simulator::advance()
+{
+	for (;;)
+	{
+		uint64_t next = UINT64_MAX;
+		if (_smuxBusy && _smuxDoneAt < next)
+			next = _smuxDoneAt;
+		if (_running && _cycleEnd < next)
+			next = _cycleEnd;
+		if (_flickerRunning && _flickerNext < next)
+			next = _flickerNext;
+		if (next > _now)
+			return;
+
+		if (_smuxBusy && _smuxDoneAt == next)
+			finishSmuxCommand();
+		else if (_running && _cycleEnd == next)
+			finishCycle();
+		else
+			runFlicker();
+	}
+}
+
+void SparkFun_AS7341X_Simulator::finishSmuxCommand()
+{
+	_smuxBusy = false;
+	_smuxCommands++;
+
+	// CFG_6 SMUX_CMD, bits 4:3
+	switch ((_registers[0xaf] >> 3) & 0x03)
+	{
+	case 0:
+		// ROM init: nothing connected
+		memset(_smux, 0, sizeof(_smux));
+		break;
+	case 1:
+		memcpy(_registers, _smux, sizeof(_smux));
+		break;
+	default:
+		memcpy(_smux, _registers, sizeof(_smux));
+		break;
+	}
+
+	_registers[0x80] &= ~0x10;
+
+	// SINT when CFG_9 SIEN_SMUX is set. With SAI an enabled SINT puts the device to sleep like any other interrupt.
+	if (_registers[0xb2] & 0x10)
+		_registers[0x93] |= 0x01;
+	if ((_registers[0xac] & 0x10) && enabledInterruptAsserted())
+		_saiAsleep = true;
+	updateInterruptPin();
+
+	// SP_EN may have been set while the command was running
+	updateSpectralState(_smuxDoneAt);
+}
+
+void SparkFun_AS7341X_Simulator::updateSpectralState(uint64_t when)
+{
+	uint8_t enable = _registers[0x80];
+	bool powered = (enable & 0x01) != 0;
+
+	// A pending SMUX command starts as soon as the device is powered
+	if (powered && (enable & 0x10) && !_smuxBusy)
+	{
+		_smuxBusy = true;
+		_smuxDoneAt = when + SIM_SMUX_COMMAND_NS;
+	}
+	if (!powered)
+		_smuxBusy = false;
+
+	bool run = powered && (enable & 0x02) && !_saiAsleep;
+	if (run && !_running)
+	{
+		_cycleStart = when;
+		_cycleEnd = when + integrationNanos();
+		_registers[0xa3] &= ~0x40;
+		_persistence = 0;
+	}
+	_running = run;
+
+	bool flicker = powered && (enable & 0x40);
+	if (flicker && !_flickerRunning)
+	{
+		_flickerNext = when + flickerSampleNanos();
+		_flickerCount = 0;
+		_flickerSaturated = false;
+	}
+	_flickerRunning = flicker;
+}
+
+uint64_t SparkFun_AS7341X_Simulator::integrationNanos()
+{
+	uint64_t steps = uint64_t(_registers[0x81] + 1) * ((_registers[0xca] | (_registers[0xcb] << 8)) + 1);
+	return steps * STEP_NS;
+}
+
+uint64_t SparkFun_AS7341X_Simulator::cyclePeriodNanos()
+{
+	uint64_t integration = integrationNanos();
+	if ((_registers[0x80] & 0x08) == 0)
+		return integration;
+
+	uint64_t wait = uint64_t(_registers[0x83] + 1) * WAIT_STEP_NS;
+	if (_registers[0xa9] & 0x04)
+		wait *= 16;
+	return (wait > integration) ? wait : integration;
+}
+
+uint64_t SparkFun_AS7341X_Simulator::flickerSampleNanos()
+{
+	uint16_t fdTime = ((_registers[0xda] & 0x07) << 8) | _registers[0xd8];
+	return uint64_t(fdTime + 1) * STEP_NS;
+}
+
+float SparkFun_AS7341X_Simulator::sceneRate(uint8_t photodiode)
+{
+	float rate = _ambient[photodiode];
+
+	// LED_ACT drives the LED cathodes, the PCA9536 pins (active low) pick the LEDs. Full drive is 258 mA.
+	uint8_t led = _bank1[0x74 - 0x60];
+	if ((led & 0x80) && _gpioExpander)
+	{
+		float drive = (4 + 2 * (led & 0x7f)) / 258.0f;
+		if (_gpioExpander->isOutput(1) && _gpioExpander->getPinLevel(1) == LOW)
+			rate += _whiteLed[photodiode] * drive;
+		if (_gpioExpander->isOutput(2) && _gpioExpander->getPinLevel(2) == LOW)
+			rate += _irLed[photodiode] * drive;
+	}
+
+	return rate;
+}
+
+void SparkFun_AS7341X_Simulator::finishCycle()
+{
+	uint64_t when = _cycleEnd;
+	uint32_t steps = uint32_t(_registers[0x81] + 1) * ((_registers[0xca] | (_registers[0xcb] << 8)) + 1);
+	float fullScale = (steps > 65535) ? 65535 : float(steps);
+	uint8_t gainCode = _registers[0xaa] & 0x1f;
+	float gain = gainFactor(gainCode);
+
+	bool saturated = false;
+	float highest = 0;
+	for (uint8_t adc = 0; adc < 6; adc++)
+	{
+		float rate = 0;
+		for (uint8_t nibble = 0; nibble < 40; nibble++)
+		{
+			uint8_t route = (_smux[nibble >> 1] >> ((nibble & 1) * 4)) & 0x0f;
+			int8_t photodiode = nibblePhotodiode[nibble];
+			if (route == adc + 1 && photodiode >= 0)
+				rate += sceneRate(photodiode) / photodiodeCount[photodiode];
+		}
+
+		float counts = rate * gain * steps;
+		if (counts >= fullScale)
+		{
+			counts = fullScale;
+			saturated = true;
+		}
+		if (counts > highest)
+			highest = counts;
+		uint16_t value = uint16_t(counts);
+		_data[adc * 2] = value & 0xff;
+		_data[adc * 2 + 1] = value >> 8;
+	}
+
+	// ASTATUS: ASAT_STATUS and the gain the data was measured with
+	_dataStatus = (saturated ? 0x80 : 0x00) | (gainCode & 0x0f);
+	_registers[0xa3] = (_registers[0xa3] & ~0x50) | 0x40 | (saturated ? 0x10 : 0x00);
+	if (saturated)
+		_registers[0x93] |= 0x80;
+
+	// Spectral AGC: CFG_10 AGC_H is 50 to 87.5 % and AGC_L 12.5 to 50 % of full scale, the next cycle uses the new gain
+	if (_registers[0xb1] & 0x04)
+	{
+		float high = fullScale * (0.5f + 0.125f * (_registers[0xb3] >> 6));
+		float low = fullScale * 0.125f * (((_registers[0xb3] >> 4) & 0x03) + 1);
+		uint8_t next = gainCode;
+		if (highest >= high && next > 0)
+			next--;
+		else if (highest < low && next < (_registers[0xcf] & 0x0f))
+			next++;
+		_registers[0xaa] = (_registers[0xaa] & ~0x1f) | next;
+	}
+
+	// Threshold check on the CFG_12 channel, APERS 0 interrupts on every cycle
+	uint8_t channel = _registers[0xb5] & 0x07;
+	if (channel > 4)
+		channel = 4;
+	uint16_t value = _data[channel * 2] | (_data[channel * 2 + 1] << 8);
+	uint16_t low = _registers[0x84] | (_registers[0x85] << 8);
+	uint16_t high = _registers[0x86] | (_registers[0x87] << 8);
+	bool outside = (value < low) || (value > high);
+	if ((_registers[0xbd] & 0x0f) == 0 || persistenceReached(outside))
+	{
+		_registers[0x93] |= 0x08;
+		if (outside)
+			_registers[0xa4] |= (value > high) ? 0x20 : 0x10;
+	}
+
+	// FIFO_MAP: bit 0 ASTATUS, bits 1 to 6 the ADC data
+	uint8_t map = _registers[0xfc];
+	if (map & 0x01)
+		_fifo.push_back(_dataStatus);
+	for (uint8_t adc = 0; adc < 6; adc++)
+		if (map & (2 << adc))
+			_fifo.push_back(_data[adc * 2] | (_data[adc * 2 + 1] << 8));
+	updateFifoLevel();
+
+	_cycles++;
+
+	// SAI: sleep at the end of the cycle once an enabled interrupt is asserted
+	if ((_registers[0xac] & 0x10) && enabledInterruptAsserted())
+	{
+		_saiAsleep = true;
+		_running = false;
+	}
+	else
+	{
+		_cycleStart += cyclePeriodNanos();
+		if (_cycleStart < when)
+			_cycleStart = when;
+		_cycleEnd = _cycleStart + integrationNanos();
+	}
+
+	updateInterruptPin();
+}
+
+bool SparkFun_AS7341X_Simulator::persistenceReached(bool outside)
+{
+	if (!outside)
+	{
+		_persistence = 0;
+		return false;
+	}
+
+	// APERS 1 to 3 count cycles one by one, above that 5 x (APERS - 3)
+	uint8_t apers = _registers[0xbd] & 0x0f;
+	uint8_t needed = (apers <= 3) ? apers : 5 * (apers - 3);
+	if (_persistence < 255)
+		_persistence++;
+	return _persistence >= needed;
+}
+
+void SparkFun_AS7341X_Simulator::runFlicker()
+{
+	uint64_t when = _flickerNext;
+	_flickerNext += flickerSampleNanos();
+
+	uint32_t steps = (((_registers[0xda] & 0x07) << 8) | _registers[0xd8]) + 1;
+	float gain = gainFactor(_registers[0xda] >> 3);
+	float phase = 2 * float(PI) * _flickerFrequency * (when * 1e-9f);
+	float counts = sceneRate(10) * gain * steps * (1 + _flickerDepth * sinf(phase));
+	float fullScale = (steps > 65535) ? 65535 : float(steps);
+	if (counts >= fullScale)
+	{
+		counts = fullScale;
+		_flickerSaturated = true;
+	}
+	if (counts < 0)
+		counts = 0;
+
+	// FIFO_WRITE_FD sends raw samples to the FIFO instead of running the detector
+	if (_registers[0xd7] & 0x80)
+	{
+		_fifo.push_back(uint16_t(counts));
+		updateFifoLevel();
+		return;
+	}
+
+	if (++_flickerCount < SIM_FLICKER_SAMPLES)
+		return;
+	_flickerCount = 0;
+
+	// Measurement valid, both frequencies evaluated, saturation and the detected frequency
+	uint8_t status = 0x2c | (_flickerSaturated ? 0x10 : 0x00);
+	if (_flickerDepth > 0 && fabsf(_flickerFrequency - 100) < 5)
+		status |= 0x01;
+	if (_flickerDepth > 0 && fabsf(_flickerFrequency - 120) < 5)
+		status |= 0x02;
+	_registers[0xdb] = status;
+	_flickerSaturated = false;
+}
+
+void SparkFun_AS7341X_Simulator::updateFifoLevel()
+{
+	while (_fifo.size() > FIFO_ENTRIES)
+	{
+		_fifo.pop_back();
+		_registers[0xa7] |= 0x80;
+	}
+	_registers[0xfd] = uint8_t(_fifo.size());
+
+	// FINT once the level reaches the CFG_8 FIFO_TH threshold (1, 4, 8 or 16 entries)
+	static const uint8_t thresholds[4] = { 1, 4, 8, 16 };
+	if (_fifo.size() >= thresholds[_registers[0xb1] >> 6])
+		_registers[0x93] |= 0x04;
+	updateInterruptPin();
+}
+
+bool SparkFun_AS7341X_Simulator::enabledInterruptAsserted()
+{
+	// SINT, FINT and AINT with their INTENAB enables (SIEN, FIEN, SP_IEN)
+	return (_registers[0x93] & _registers[0xf9] & 0x0d) != 0;
+}
+
+void SparkFun_AS7341X_Simulator::updateInterruptPin()
+{
+	bool asserted = enabledInterruptAsserted();
+	if (asserted == _interruptAsserted)
+		return;
+
+	_interruptAsserted = asserted;
+	if (_interruptPin >= 0)
+		hostSetPinLevel(_interruptPin, asserted ? LOW : HIGH);
+}
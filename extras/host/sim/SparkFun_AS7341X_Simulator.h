@@ -0,0 +1,182 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the register model of the AS7341 used by the host build.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_SIMULATOR__
+#define __SparkFun_AS7341X_SIMULATOR__
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <deque>
+#include "SparkFun_PCA9536_Simulator.h"
+
+// Photodiode groups of the simulated scene, in the order of AS7341X_PHOTODIODE
+const uint8_t SIM_PHOTODIODE_COUNT = 11;
+
+// Time a SMUX command takes once SMUXEN is set, in nanoseconds. Not in the datasheet, a typical figure.
+const uint64_t SIM_SMUX_COMMAND_NS = 100000;
+
+// Raw flicker samples the flicker engine looks at before it reports a result in FD_STATUS
+const uint16_t SIM_FLICKER_SAMPLES = 128;
+
+// Register level model of the AS7341 on the simulated I2C bus, running on the host virtual clock:
+// - CFG_0 REG_BANK selects 0x60 to 0x74 (set) or 0x80 and above (clear). CFG_0 itself is always reachable,
+//   any other access to the hidden bank is ignored and counted in getBankViolations().
+// - 0x00 to 0x13 is the SMUX RAM. SMUXEN runs the CFG_6 SMUX command (ROM init, read or write the RAM) and clears
+//   itself SIM_SMUX_COMMAND_NS later, raising SINT when CFG_9 SIEN_SMUX is set.
+// - SP_EN with PON starts a spectral cycle. AVALID and the data follow (ATIME + 1) x (ASTEP + 1) x 2.78 us later.
+//   With WEN the cycle period is the longer of that and the WTIME period (x16 with WLONG), as the library assumes.
+//   Counts are the scene rate of every photodiode routed to an ADC x gain x integration steps, clipped to full scale.
+// - AINT follows APERS and the SP_TH thresholds on the CFG_12 channel. SAI puts the engine to sleep while any enabled
+//   interrupt is asserted. The FIFO takes the FIFO_MAP channels or raw flicker samples, and FDEN reports 100/120 Hz flicker.
+// - FD_CFG0 and FD_TIME writes while the flicker engine runs are ignored and counted in getFlickerViolations().
+// - The LED register and the PCA9536 pins gate the board LEDs, which add their own light to the scene.
+// - CFG_8 SP_AGC_EN moves the CFG_1 gain one step per cycle, down when the highest ADC reaches the CFG_10 high
+//   hysteresis and up below the low one, within AGC_GAIN_MAX. ASTATUS keeps the gain the data was measured with.
+// The exact on-chip AGC algorithm and the autozero cycles are not modelled.
+class SparkFun_AS7341X_Simulator : public HostI2CDevice, public HostClockListener
+{
+private:
+	// Bank 0 view (SMUX RAM and 0x80 and above) and bank 1 registers 0x60 to 0x74
+	uint8_t _registers[256];
+	uint8_t _bank1[0x15];
+
+	// SMUX configuration in use, the RAM only holds what the next command writes
+	uint8_t _smux[20];
+	uint8_t _pointer = 0;
+
+	uint64_t _now = 0;
+
+	// A SMUX command is running until _smuxDoneAt
+	bool _smuxBusy = false;
+	uint64_t _smuxDoneAt = 0;
+
+	// Spectral engine state. _running is PON and SP_EN and not asleep after an interrupt.
+	bool _running = false;
+	bool _saiAsleep = false;
+	uint64_t _cycleStart = 0;
+	uint64_t _cycleEnd = 0;
+	uint8_t _persistence = 0;
+
+	// Data registers 0x95 to 0xA0 of the last cycle and the copy latched by reading ASTATUS
+	uint8_t _data[12];
+	uint8_t _latched[12];
+	uint8_t _dataStatus = 0;
+	uint8_t _latchedStatus = 0;
+
+	// Flicker engine
+	bool _flickerRunning = false;
+	uint64_t _flickerNext = 0;
+	uint16_t _flickerCount = 0;
+	bool _flickerSaturated = false;
+
+	std::deque<uint16_t> _fifo;
+
+	// Scene, in counts per integration step at 1x gain for each photodiode group
+	float _ambient[SIM_PHOTODIODE_COUNT];
+	float _whiteLed[SIM_PHOTODIODE_COUNT];
+	float _irLed[SIM_PHOTODIODE_COUNT];
+	float _flickerFrequency = 0;
+	float _flickerDepth = 0;
+
+	SparkFun_PCA9536_Simulator* _gpioExpander = nullptr;
+	int _interruptPin = -1;
+	bool _interruptAsserted = false;
+	uint8_t _gpioLevel = 0;
+
+	uint32_t _bankViolations = 0;
+	uint32_t _flickerViolations = 0;
+	uint32_t _smuxCommands = 0;
+	uint32_t _cycles = 0;
+
+	// Register access through the bank selection, null for the hidden bank
+	uint8_t* locate(uint8_t address);
+
+	uint8_t readRegister(uint8_t address);
+	void writeRegister(uint8_t address, uint8_t value);
+	void writeEnable(uint8_t value);
+
+	// Brings the model up to _now
+	void advance();
+	void finishSmuxCommand();
+	void updateSpectralState(uint64_t when);
+	void finishCycle();
+	void runFlicker();
+
+	uint64_t integrationNanos();
+	uint64_t cyclePeriodNanos();
+	uint64_t flickerSampleNanos();
+	float sceneRate(uint8_t photodiode);
+	bool persistenceReached(bool outside);
+	void updateFifoLevel();
+	void updateInterruptPin();
+
+	// True while an enabled interrupt is asserted: INT is driven low and a device with SAI stays asleep
+	bool enabledInterruptAsserted();
+
+public:
+	SparkFun_AS7341X_Simulator();
+	~SparkFun_AS7341X_Simulator();
+
+	void i2cWrite(const uint8_t* data, size_t length) override;
+	void i2cRead(uint8_t* buffer, size_t length) override;
+	void onClock(uint64_t nowNanos) override;
+
+	// Back to power up state, the scene is kept
+	void reset();
+
+	// Light reaching a photodiode group (AS7341X_PHOTODIODE order), in counts per integration step at 1x gain
+	void setAmbient(uint8_t photodiode, float rate);
+	void setAmbient(float rate);
+
+	// Light the white and IR LEDs add at full drive when their PCA9536 pin is low and LED_ACT is set
+	void setWhiteLed(uint8_t photodiode, float rate);
+	void setIRLed(uint8_t photodiode, float rate);
+
+	// Flicker of the ambient light seen by the flicker photodiode: frequency in Hz (0 for none) and depth (0 to 1)
+	void setFlicker(float frequency, float depth = 0.5f);
+
+	// Connects the PCA9536 whose pins 1 (white) and 2 (IR) switch the LED cathodes
+	void attachGpioExpander(SparkFun_PCA9536_Simulator& expander);
+
+	// Host pin driven low while INT is asserted, -1 for none
+	void setInterruptPin(int pin);
+
+	// Level applied to the AS7341 GPIO pin
+	void setGpioLevel(uint8_t level);
+
+	// Register value without side effects, bank 1 for 0x60 to 0x74
+	uint8_t peekRegister(uint8_t address);
+
+	// SMUX configuration in use
+	const uint8_t* getActiveSmux() { return _smux; }
+
+	bool isPoweredOn() { return (_registers[0x80] & 0x01) != 0; }
+	bool isIntegrating() { return _running; }
+	bool isInterruptAsserted() { return _interruptAsserted; }
+
+	// Accesses to registers hidden by the REG_BANK selection, always 0 for a correct driver
+	uint32_t getBankViolations() { return _bankViolations; }
+
+	// Flicker configuration writes ignored because FDEN was set, always 0 for a correct driver
+	uint32_t getFlickerViolations() { return _flickerViolations; }
+
+	uint32_t getSmuxCommands() { return _smuxCommands; }
+	uint32_t getCycles() { return _cycles; }
+};
+
+#endif // ! __SparkFun_AS7341X_SIMULATOR__
@@ -0,0 +1,104 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the register model of the PCA9536 GPIO expander driving the board LEDs.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_PCA9536_Simulator.h"
+
+void SparkFun_PCA9536_Simulator::i2cWrite(const uint8_t* data, size_t length)
+{
+	if (length == 0)
+		return;
+
+	_pointer = data[0] & 0x03;
+	for (size_t i = 1; i < length; i++)
+	{
+		switch (_pointer)
+		{
+		case 1:
+			_output = data[i];
+			break;
+		case 2:
+			_polarity = data[i];
+			break;
+		case 3:
+			_configuration = data[i];
+			break;
+		default:
+			// The input port is read only
+			break;
+		}
+	}
+}
+
+void SparkFun_PCA9536_Simulator::i2cRead(uint8_t* buffer, size_t length)
+{
+	uint8_t value;
+	switch (_pointer)
+	{
+	case 0:
+		value = 0xf0;
+		for (uint8_t pin = 0; pin < 4; pin++)
+			value |= getPinLevel(pin) << pin;
+		value ^= _polarity & 0x0f;
+		break;
+	case 1:
+		value = _output;
+		break;
+	case 2:
+		value = _polarity;
+		break;
+	default:
+		value = _configuration;
+		break;
+	}
+
+	for (size_t i = 0; i < length; i++)
+		buffer[i] = value;
+}
+
+uint8_t SparkFun_PCA9536_Simulator::getPinLevel(uint8_t pin)
+{
+	if (pin > 3)
+		return LOW;
+	if (isOutput(pin))
+		return (_output >> pin) & 0x01;
+	return (_externalLevels >> pin) & 0x01;
+}
+
+bool SparkFun_PCA9536_Simulator::isOutput(uint8_t pin)
+{
+	return pin < 4 && (_configuration & (1 << pin)) == 0;
+}
+
+void SparkFun_PCA9536_Simulator::setExternalLevel(uint8_t pin, uint8_t level)
+{
+	if (pin > 3)
+		return;
+	if (level)
+		_externalLevels |= (1 << pin);
+	else
+		_externalLevels &= ~(1 << pin);
+}
+
+void SparkFun_PCA9536_Simulator::reset()
+{
+	_output = 0xff;
+	_polarity = 0x00;
+	_configuration = 0xff;
+	_pointer = 0;
+	_externalLevels = 0x0f;
+}
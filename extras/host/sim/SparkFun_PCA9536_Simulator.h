@@ -0,0 +1,56 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the register model of the PCA9536 GPIO expander driving the board LEDs.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_PCA9536_SIMULATOR__
+#define __SparkFun_PCA9536_SIMULATOR__
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Four pin GPIO expander: input, output, polarity inversion and configuration registers behind a pointer register.
+// The pointer does not auto-increment, so every byte of a burst goes to the same register.
+class SparkFun_PCA9536_Simulator : public HostI2CDevice
+{
+private:
+	// Output, polarity and configuration registers at power up: outputs high, no inversion, all pins inputs
+	uint8_t _output = 0xff;
+	uint8_t _polarity = 0x00;
+	uint8_t _configuration = 0xff;
+	uint8_t _pointer = 0;
+
+	// Level applied from outside to the pins configured as inputs
+	uint8_t _externalLevels = 0x0f;
+
+public:
+	void i2cWrite(const uint8_t* data, size_t length) override;
+	void i2cRead(uint8_t* buffer, size_t length) override;
+
+	// Returns the level of a pin: the output register for outputs, the external level for inputs
+	uint8_t getPinLevel(uint8_t pin);
+
+	// Returns true if a pin is configured as an output
+	bool isOutput(uint8_t pin);
+
+	// Sets the level an external circuit applies to a pin
+	void setExternalLevel(uint8_t pin, uint8_t level);
+
+	// Back to power up state
+	void reset();
+};
+
+#endif // ! __SparkFun_PCA9536_SIMULATOR__
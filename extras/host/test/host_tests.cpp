@@ -0,0 +1,957 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file runs the library against the simulated board and checks what it reads and leaves behind.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <Wire.h>
+#include "SparkFun_AS7341X_Arduino_Library.h"
+#include "SparkFun_AS7341X_AutoExposure.h"
+#include "SparkFun_AS7341X_Color.h"
+#include "SparkFun_AS7341X_Frame.h"
+#include "SparkFun_AS7341X_LowPower.h"
+#include "SparkFun_AS7341X_Manager.h"
+#include "SparkFun_AS7341X_Simulator.h"
+#include "SparkFun_PCA9536_Simulator.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			failures++; \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(value, expected, tolerance) \
+	do \
+	{ \
+		double actual_ = (value); \
+		if (fabs(actual_ - (expected)) > (tolerance)) \
+		{ \
+			printf("  %s:%d: %s is %g, expected %g\n", __FILE__, __LINE__, #value, actual_, double(expected)); \
+			failures++; \
+		} \
+	} while (0)
+
+// SparkFun board on a bus: the AS7341 at 0x39 and the PCA9536 at 0x41, with F1 to NIR at 0.05 to 0.5 counts per step
+struct Board
+{
+	TwoWire& bus;
+	SparkFun_AS7341X_Simulator sensor;
+	SparkFun_PCA9536_Simulator gpio;
+
+	Board(TwoWire& wirePort = Wire) : bus(wirePort)
+	{
+		bus.attach(DEFAULT_AS7341X_ADDR, sensor);
+		bus.attach(0x41, gpio);
+		sensor.attachGpioExpander(gpio);
+		for (uint8_t i = 0; i < 10; i++)
+			sensor.setAmbient(i, 0.05f * (i + 1));
+	}
+
+	~Board()
+	{
+		bus.detach(DEFAULT_AS7341X_ADDR);
+		bus.detach(0x41);
+	}
+};
+
+// Expected raw count of a channel (0 = F1 ... 9 = NIR) for the board scene at gain 1x and the default 30 x 600 steps
+static double expectedCounts(uint8_t channel, double scale = 1)
+{
+	return 0.05 * (channel + 1) * 18000 * scale;
+}
+
+static bool beginAt1x(SparkFun_AS7341X& as7341, TwoWire& wirePort = Wire)
+{
+	if (!as7341.begin(DEFAULT_AS7341X_ADDR, wirePort))
+		return false;
+	as7341.setGain(AS7341X_GAIN::GAIN_X1);
+	return true;
+}
+
+static void testBegin()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+
+	CHECK(as7341.begin());
+	CHECK(board.sensor.isPoweredOn());
+	CHECK(as7341.getATIME() == 29);
+	CHECK(as7341.getASTEP() == 599);
+	CHECK(board.sensor.peekRegister(REGISTER_ATIME) == 29);
+
+	// Power LED on, white and IR LEDs off (active low outputs)
+	for (uint8_t pin = 0; pin < 3; pin++)
+		CHECK(board.gpio.isOutput(pin));
+	CHECK(board.gpio.getPinLevel(POWER_LED_GPIO) == LOW);
+	CHECK(board.gpio.getPinLevel(WHITE_LED_GPIO) == HIGH);
+	CHECK(board.gpio.getPinLevel(IR_LED_GPIO) == HIGH);
+
+	CHECK(board.sensor.getBankViolations() == 0);
+}
+
+static void testMissingDevice()
+{
+	SparkFun_AS7341X as7341;
+	CHECK(!as7341.begin());
+}
+
+static void testReadAllChannels()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+
+	unsigned int data[12];
+	uint64_t start = hostNanos();
+	CHECK(as7341.readAllChannels(data));
+	uint64_t elapsed = hostNanos() - start;
+
+	// F1 to F4, Clear, NIR, then F5 to F8, Clear, NIR
+	static const uint8_t layout[12] = { 0, 1, 2, 3, 8, 9, 4, 5, 6, 7, 8, 9 };
+	for (uint8_t i = 0; i < 12; i++)
+		CHECK_NEAR(data[i], expectedCounts(layout[i]), 1);
+
+	// Two integrations of 30 x 600 steps of 2.78 us
+	CHECK(elapsed >= 2ULL * 18000 * 2780);
+	CHECK(elapsed < 2ULL * 18000 * 2780 + 20000000ULL);
+	CHECK(!as7341.isMeasurementSaturated(0));
+	CHECK(as7341.getMeasurementGain(1) == AS7341X_GAIN::GAIN_X1);
+	CHECK(board.sensor.getBankViolations() == 0);
+}
+
+static void testFixedBasicCounts()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(as7341.begin());
+
+	// Shortest, default and longest integration, each with a scene giving about 2000 counts at 1x on F4
+	static const struct { byte aTime; unsigned int aStep; } settings[] = { { 0, 0 }, { 29, 599 }, { 255, 65534 } };
+	for (uint8_t s = 0; s < sizeof(settings) / sizeof(settings[0]); s++)
+	{
+		as7341.setATIME(settings[s].aTime);
+		as7341.setASTEP(settings[s].aStep);
+		double steps = (settings[s].aTime + 1.0) * (settings[s].aStep + 1.0);
+		for (uint8_t i = 0; i < 10; i++)
+			board.sensor.setAmbient(i, 500 / steps * (i + 1));
+
+		for (byte code = 0; code <= 10; code++)
+		{
+			as7341.setGain(AS7341X_GAIN(code));
+			float basicCounts[12];
+			uint32_t fixedBasicCounts[12];
+			CHECK(as7341.readAllChannelsBasicCounts(basicCounts));
+			CHECK(as7341.readAllChannelsBasicCountsFixed(fixedBasicCounts));
+
+			// The fixed point path truncates, so it may be one LSB low on top of the float rounding.
+			// Past 65536 basic counts it saturates.
+			for (uint8_t i = 0; i < 12; i++)
+			{
+				double expected = double(basicCounts[i]) * 65536;
+				if (expected >= 4294967295.0)
+					CHECK(fixedBasicCounts[i] == 0xffffffff);
+				else
+					CHECK_NEAR(fixedBasicCounts[i], expected, 1 + expected * 1e-6);
+			}
+		}
+	}
+}
+
+static void testSingleChannels()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+
+	CHECK_NEAR(as7341.read415nm(), expectedCounts(0), 1);
+	CHECK_NEAR(as7341.read555nm(), expectedCounts(4), 1);
+	CHECK_NEAR(as7341.read680nm(), expectedCounts(7), 1);
+	CHECK_NEAR(as7341.readClear(), expectedCounts(8), 1);
+	CHECK_NEAR(as7341.readNIR(), expectedCounts(9), 1);
+
+	// Gain and integration time scale the counts
+	as7341.setGain(AS7341X_GAIN::GAIN_X4);
+	as7341.setATIME(14);
+	CHECK_NEAR(as7341.read445nm(), expectedCounts(1, 4 * 0.5), 1);
+
+	// Saturation is reported through ASTATUS
+	as7341.setGain(AS7341X_GAIN::GAIN_X512);
+	CHECK(as7341.readNIR() == 9000);
+	CHECK(as7341.isMeasurementSaturated(0));
+}
+
+static void testReadChannels()
+{
+	Board board;
+	SparkFun_AS7341X as7341(AS7341X_DEVICE::AS7341);
+	CHECK(beginAt1x(as7341));
+
+	// readAllChannels index of every optical channel (F1 to F8, Clear, NIR)
+	static const uint8_t allChannelsIndex[10] = { 0, 1, 2, 3, 6, 7, 8, 9, 4, 5 };
+	unsigned int all[12];
+	CHECK(as7341.readAllChannels(all));
+
+	static const uint16_t masks[] = { AS7341X_CHANNEL_680NM, AS7341X_CHANNEL_415NM | AS7341X_CHANNEL_NIR, 0x01f0, 0x003f,
+		0x007f, 0x02aa, 0x03fe, AS7341X_CHANNEL_ALL };
+	for (uint8_t flicker = 0; flicker < 2; flicker++)
+	{
+		// ADC5 belongs to the flicker engine while background detection runs
+		if (flicker)
+			CHECK(as7341.startFlickerDetection());
+		uint8_t adcCount = flicker ? 5 : 6;
+
+		for (uint8_t m = 0; m < sizeof(masks) / sizeof(masks[0]); m++)
+		{
+			uint8_t selected = 0;
+			for (uint8_t channel = 0; channel < 10; channel++)
+				selected += (masks[m] >> channel) & 1;
+
+			unsigned int data[10];
+			for (uint8_t channel = 0; channel < 10; channel++)
+				data[channel] = 0xdead;
+
+			uint32_t cycles = board.sensor.getCycles();
+			uint32_t smuxCommands = board.sensor.getSmuxCommands();
+			CHECK(as7341.readChannels(masks[m], data));
+			uint32_t passes = (selected + adcCount - 1) / adcCount;
+			CHECK(board.sensor.getCycles() - cycles == passes);
+			CHECK(board.sensor.getSmuxCommands() - smuxCommands == passes);
+
+			// Selected channels match readAllChannels, the others are left alone
+			for (uint8_t channel = 0; channel < 10; channel++)
+			{
+				if (masks[m] & (1 << channel))
+					CHECK(data[channel] == all[allChannelsIndex[channel]]);
+				else
+					CHECK(data[channel] == 0xdead);
+			}
+		}
+	}
+	as7341.stopFlickerDetection();
+}
+
+static void testAutomaticGain()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(as7341.begin());
+	as7341.setGain(AS7341X_GAIN::GAIN_X2);
+	as7341.enableAutomaticGain();
+
+	// Basic counts do not depend on the gain: rate x 18000 steps / 50.04 ms
+	const double tint = 18000 * 0.00278;
+
+	// NIR saturates the first pass at 2x, so the AGC runs the second one at 1x. Each pass is scaled by the gain ASTATUS
+	// reported for it, only the clipped NIR of the first pass is off.
+	float basicCounts[12];
+	CHECK(as7341.readAllChannelsBasicCounts(basicCounts));
+	CHECK(as7341.getMeasurementGain(0) == AS7341X_GAIN::GAIN_X2);
+	CHECK(as7341.getMeasurementGain(1) == AS7341X_GAIN::GAIN_X1);
+	static const uint8_t layout[12] = { 0, 1, 2, 3, 8, 9, 4, 5, 6, 7, 8, 9 };
+	for (uint8_t i = 0; i < 12; i++)
+		if (i != 5)
+			CHECK_NEAR(basicCounts[i], 0.05 * (layout[i] + 1) * 18000 / tint, 0.05);
+
+	// F1 alone is dim at 1x, the AGC has already moved CFG_1 to 2x by the time the data is read
+	CHECK_NEAR(as7341.readBasicCount415nm(), 0.05 * 18000 / tint, 0.05);
+	CHECK(as7341.getGain() == AS7341X_GAIN::GAIN_X2);
+	CHECK_NEAR(as7341.readBasicCountFixed415nm() / 65536.0, 0.05 * 18000 / tint, 0.05);
+	CHECK(as7341.getGain() == AS7341X_GAIN::GAIN_X4);
+	as7341.disableAutomaticGain();
+}
+
+static void testLeds()
+{
+	Board board;
+	board.sensor.setWhiteLed(0, 12.9f);
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+
+	unsigned int dark = as7341.read415nm();
+
+	// 12.9 counts per step at 258 mA is 0.2 at the 4 mA default drive
+	as7341.enableWhiteLed();
+	CHECK(board.gpio.getPinLevel(WHITE_LED_GPIO) == LOW);
+	CHECK((board.sensor.peekRegister(REGISTER_LED) & 0x80) != 0);
+	CHECK_NEAR(as7341.read415nm(), dark + 0.2 * 18000, 2);
+
+	as7341.disableWhiteLed();
+	CHECK(board.gpio.getPinLevel(WHITE_LED_GPIO) == HIGH);
+	CHECK(as7341.read415nm() == dark);
+
+	as7341.disablePowerLed();
+	CHECK(board.gpio.getPinLevel(POWER_LED_GPIO) == HIGH);
+	CHECK(board.sensor.getBankViolations() == 0);
+}
+
+static void testDifferential()
+{
+	Board board;
+
+	// The white LED adds 0.1, 0.2 or 0.3 counts per step at the 4 mA default drive, depending on the channel
+	for (uint8_t i = 0; i < 10; i++)
+		board.sensor.setWhiteLed(i, 6.45f * (i % 3 + 1));
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+
+	unsigned int difference[12];
+	unsigned int ambient[12];
+	CHECK(as7341.readAllChannelsDifferential(AS7341X_LED::WHITE, difference, ambient));
+
+	// LED on minus ambient leaves the LED light only
+	static const uint8_t layout[12] = { 0, 1, 2, 3, 8, 9, 4, 5, 6, 7, 8, 9 };
+	for (uint8_t i = 0; i < 12; i++)
+	{
+		CHECK_NEAR(ambient[i], expectedCounts(layout[i]), 1);
+		CHECK_NEAR(difference[i], 0.1 * (layout[i] % 3 + 1) * 18000, 2);
+	}
+
+	// The LED is left off and a plain reading sees the ambient light only
+	CHECK((board.sensor.peekRegister(REGISTER_LED) & 0x80) == 0);
+	CHECK(board.gpio.getPinLevel(WHITE_LED_GPIO) == HIGH);
+	unsigned int data[12];
+	CHECK(as7341.readAllChannels(data));
+	for (uint8_t i = 0; i < 12; i++)
+		CHECK(data[i] == ambient[i]);
+}
+
+static void testFlicker()
+{
+	Board board;
+	board.sensor.setAmbient(10, 0.01f);
+	SparkFun_AS7341X as7341(AS7341X_DEVICE::AS7341);
+	CHECK(as7341.begin());
+
+	board.sensor.setFlicker(100);
+	CHECK(as7341.getFlickerFrequency() == 100);
+
+	// Same FD gain (32x, bits 7:3) and integration time (0x3ff) as background detection
+	CHECK((board.sensor.peekRegister(REGISTER_FD_TIME_2) >> 3) == byte(AS7341X_GAIN::GAIN_X32));
+	CHECK((board.sensor.peekRegister(REGISTER_FD_TIME_2) & 0x07) == 0x03);
+	CHECK(board.sensor.peekRegister(REGISTER_FD_TIME_1) == 0xff);
+
+	board.sensor.setFlicker(120);
+	CHECK(as7341.getFlickerFrequency() == 120);
+	board.sensor.setFlicker(0, 0);
+	CHECK(as7341.getFlickerFrequency() == 0);
+	CHECK(as7341.getLastError() == ERROR_NONE);
+	CHECK((board.sensor.peekRegister(REGISTER_ENABLE) & 0x40) == 0);
+	CHECK(board.sensor.getFlickerViolations() == 0);
+}
+
+static void testWaveformDuringBackgroundDetection()
+{
+	Board board;
+	board.sensor.setAmbient(10, 0.01f);
+	board.sensor.setFlicker(100);
+	SparkFun_AS7341X as7341(AS7341X_DEVICE::AS7341);
+	CHECK(as7341.begin());
+	CHECK(as7341.startFlickerDetection());
+
+	uint16_t samples[64];
+	CHECK(as7341.captureFlickerWaveform(samples, 64, 1000));
+	uint16_t low = 0xffff;
+	uint16_t high = 0;
+	for (uint8_t i = 0; i < 64; i++)
+	{
+		if (samples[i] < low)
+			low = samples[i];
+		if (samples[i] > high)
+			high = samples[i];
+	}
+	CHECK(low > 0);
+	CHECK(high > low + 50);
+	CHECK(board.sensor.getFlickerViolations() == 0);
+
+	// Background detection resumes with its own settings and reports again
+	CHECK((board.sensor.peekRegister(REGISTER_FD_CFG0) & 0x80) == 0);
+	CHECK((board.sensor.peekRegister(REGISTER_ENABLE) & 0x40) != 0);
+	unsigned long start = millis();
+	while (!as7341.updateFlickerDetection() && millis() - start < 2000)
+		delay(10);
+	CHECK(as7341.getFlickerResult() == 100);
+}
+
+static void testFifoDrain()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+
+	// ADC0 (F1) and ADC2 (F3): two entries per cycle
+	CHECK(as7341.startFifoStreaming(0x05));
+	CHECK(as7341.getFifoChannelCount() == 2);
+	uint32_t cycles = board.sensor.getCycles();
+	delay(175);
+	cycles = board.sensor.getCycles() - cycles;
+	CHECK(cycles == 3);
+
+	// Only what fits is moved, the rest stays on the sensor for the next drain
+	uint16_t storage[5];
+	SparkFun_AS7341X_FifoBuffer buffer;
+	buffer.begin(storage, 5);
+	CHECK(as7341.drainFifo(buffer) == 4);
+	CHECK(board.sensor.peekRegister(REGISTER_FIFO_LVL) == 2 * cycles - 4);
+
+	for (uint32_t i = 0; i < 2 * cycles; i++)
+	{
+		if (buffer.available() == 0)
+			CHECK(as7341.drainFifo(buffer) == 2 * cycles - 4);
+
+		uint16_t value;
+		CHECK(buffer.pop(value));
+		CHECK_NEAR(value, expectedCounts((i % 2) ? 2 : 0), 1);
+	}
+	CHECK(board.sensor.peekRegister(REGISTER_FIFO_LVL) == 0);
+	CHECK(as7341.drainFifo(buffer) == 0);
+	CHECK(!buffer.overflowed());
+	as7341.stopFifoStreaming();
+}
+
+static void testContinuousMeasurement()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+
+	// 30 x 600 steps take 50 ms, a 40 ms cycle cannot hold them and the sensor is left alone
+	CHECK(!as7341.startContinuousMeasurement(40));
+	CHECK(as7341.getLastError() == ERROR_AS7341X_INVALID_WAIT_TIME);
+	CHECK((board.sensor.peekRegister(REGISTER_ENABLE) & 0x0a) == 0);
+
+	CHECK(as7341.startContinuousMeasurement(100));
+	CHECK_NEAR(as7341.getWaitTime(), 100, 2.78);
+
+	// Every sample gets the next sequence number, one WTIME period after the previous one
+	uint32_t sequence = 0;
+	unsigned long timestamps[4];
+	unsigned long start = millis();
+	while (sequence < 4 && millis() - start < 2000)
+	{
+		if (!as7341.updateContinuousMeasurement())
+		{
+			delay(1);
+			continue;
+		}
+
+		CHECK(as7341.getSampleSequence() == sequence + 1);
+		timestamps[sequence++] = as7341.getSampleTimestamp();
+
+		unsigned int data[6];
+		CHECK(as7341.getLatestSample(data) == sequence);
+		CHECK_NEAR(data[0], expectedCounts(0), 1);
+		CHECK_NEAR(data[5], expectedCounts(9), 1);
+	}
+	CHECK(sequence == 4);
+	for (uint8_t i = 1; i < sequence; i++)
+		CHECK_NEAR(timestamps[i] - timestamps[i - 1], as7341.getWaitTime(), 2);
+	as7341.stopContinuousMeasurement();
+}
+
+static void testLowPowerScheduler()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+	SparkFun_AS7341X_LowPower scheduler(as7341);
+
+	CHECK(scheduler.start(500));
+	uint32_t samples = 0;
+	unsigned long start = millis();
+	while (samples < 3 && millis() - start < 5000)
+	{
+		if (!scheduler.service())
+		{
+			delay(scheduler.getIdleTime());
+			continue;
+		}
+
+		// Between samples the sensor is off and SP_EN does not wait for the next PON
+		samples++;
+		CHECK(!board.sensor.isPoweredOn());
+		CHECK((board.sensor.peekRegister(REGISTER_ENABLE) & 0x02) == 0);
+
+		AS7341X_SAMPLE sample;
+		CHECK(scheduler.getResult(sample));
+		CHECK_NEAR(sample.channels[0], expectedCounts(0), 1);
+		CHECK_NEAR(sample.channels[6], expectedCounts(4), 1);
+	}
+	CHECK(samples == 3);
+	scheduler.stop();
+}
+
+static void testLowPowerSensorTimed()
+{
+	Board board;
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+	SparkFun_AS7341X_LowPower scheduler(as7341);
+
+	// WTIME paces the samples and SAI holds the sensor asleep until each one is collected
+	CHECK(scheduler.start(200, AS7341X_POWER_SCHEDULE::SENSOR_TIMED));
+	uint32_t samples = 0;
+	unsigned long start = millis();
+	while (samples < 3 && millis() - start < 5000)
+	{
+		if (!scheduler.service())
+		{
+			delay(scheduler.getIdleTime());
+			continue;
+		}
+
+		samples++;
+		CHECK(!board.sensor.isIntegrating());
+
+		AS7341X_SAMPLE sample;
+		CHECK(scheduler.getResult(sample));
+		CHECK_NEAR(sample.channels[0], expectedCounts(0), 1);
+		CHECK_NEAR(sample.channels[4], expectedCounts(8), 1);
+	}
+	CHECK(samples == 3);
+	scheduler.stop();
+}
+
+static void testManager()
+{
+	TwoWire secondBus;
+	Board first;
+	Board second(secondBus);
+	second.sensor.setAmbient(0.1f);
+
+	SparkFun_AS7341X left;
+	SparkFun_AS7341X right;
+	SparkFun_AS7341X_Manager manager;
+	CHECK(manager.addSensor(left) == 0);
+	CHECK(manager.addSensor(right, secondBus) == 1);
+	CHECK(manager.beginAll());
+	CHECK(first.sensor.isPoweredOn() && second.sensor.isPoweredOn());
+
+	// begin() leaves the default 256x, which saturates both scenes
+	left.setGain(AS7341X_GAIN::GAIN_X1);
+	right.setGain(AS7341X_GAIN::GAIN_X1);
+
+	unsigned int data[24];
+	CHECK(manager.readAll(data));
+	CHECK_NEAR(data[0], expectedCounts(0), 1);
+	CHECK_NEAR(data[12], 0.1 * 18000, 1);
+	CHECK(manager.getErrorCount() == 0);
+}
+
+static void testAutoExposureShortensIntegration()
+{
+	Board board;
+	board.sensor.setAmbient(1.0f);
+	SparkFun_AS7341X as7341;
+	CHECK(as7341.begin());
+	SparkFun_AS7341X_AutoExposure exposure(as7341);
+
+	// 256 x 1000 steps at 0.5x fill to twice the 65535 ceiling: gain has nothing left, integration has to go down
+	as7341.setGain(AS7341X_GAIN::GAIN_HALF);
+	as7341.setATIME(255);
+	as7341.setASTEP(999);
+	exposure.setBaseIntegration(255, 999);
+
+	unsigned int counts[12];
+	CHECK(as7341.readAllChannels(counts));
+	bool saturated = as7341.isMeasurementSaturated(0) || as7341.isMeasurementSaturated(1);
+	CHECK(saturated);
+	CHECK(!exposure.update(counts, 12, saturated));
+
+	// Shortened no further than 65535 steps, below that the fill level would not drop
+	AS7341X_EXPOSURE_DECISION decision;
+	CHECK(exposure.getDecision(0, decision));
+	CHECK(decision.nextGain == AS7341X_GAIN::GAIN_HALF);
+	uint32_t steps = uint32_t(decision.nextATime + 1) * (uint32_t(decision.nextAStep) + 1);
+	CHECK(steps >= 65535);
+	CHECK(steps < 256000UL);
+
+	// The next reading lands in the 60 +/- 25 % window
+	CHECK(as7341.readAllChannels(counts));
+	saturated = as7341.isMeasurementSaturated(0) || as7341.isMeasurementSaturated(1);
+	CHECK(!saturated);
+	CHECK(exposure.update(counts, 12, saturated));
+	CHECK(exposure.getDecision(0, decision));
+	CHECK(!decision.saturated);
+	CHECK_NEAR(double(decision.peak) / decision.fullScale, 0.6, 0.25);
+}
+
+static void testAutoExposureOutOfRange()
+{
+	Board board;
+	board.sensor.setAmbient(3.0f);
+	SparkFun_AS7341X as7341;
+	CHECK(as7341.begin());
+	SparkFun_AS7341X_AutoExposure exposure(as7341);
+
+	// 3 counts per step at 0.5x fills 150 % of any integration up to 65535 steps: nothing left to change
+	as7341.setGain(AS7341X_GAIN::GAIN_HALF);
+	unsigned int counts[12];
+	CHECK(as7341.readAllChannels(counts));
+	CHECK(!exposure.update(counts, 12, as7341.isMeasurementSaturated(0) || as7341.isMeasurementSaturated(1)));
+
+	AS7341X_EXPOSURE_DECISION decision;
+	CHECK(exposure.getDecision(0, decision));
+	CHECK(decision.saturated);
+	CHECK(decision.unreachable);
+	CHECK(decision.nextGain == AS7341X_GAIN::GAIN_HALF);
+	CHECK(decision.nextATime == 29);
+	CHECK(decision.nextAStep == 599);
+}
+
+static void testSampleBuffer()
+{
+	AS7341X_SAMPLE storage[4];
+	SparkFun_AS7341X_SampleBuffer buffer;
+	buffer.begin(storage, 4);
+	AS7341X_SAMPLE sample = {};
+
+	// Empty
+	CHECK(buffer.available() == 0);
+	CHECK(buffer.freeSpace() == 3);
+	CHECK(!buffer.pop(sample));
+	CHECK(buffer.peek() == nullptr);
+
+	// Ten rounds of two pushes and two pops walk the indices around the four slots several times
+	uint32_t pushed = 0;
+	uint32_t popped = 0;
+	for (uint8_t round = 0; round < 10; round++)
+	{
+		for (uint8_t i = 0; i < 2; i++)
+		{
+			sample.timestamp = pushed++;
+			CHECK(buffer.push(sample));
+		}
+		CHECK(buffer.available() == 2);
+		for (uint8_t i = 0; i < 2; i++)
+		{
+			CHECK(buffer.pop(sample));
+			CHECK(sample.timestamp == popped++);
+		}
+	}
+
+	// Full: one slot stays free, the next push is dropped and counted, nothing queued is overwritten
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		AS7341X_SAMPLE* slot = buffer.reserve();
+		CHECK(slot != nullptr);
+		if (slot == nullptr)
+			return;
+		slot->timestamp = pushed++;
+		buffer.commit();
+	}
+	CHECK(buffer.available() == 3);
+	CHECK(buffer.freeSpace() == 0);
+	CHECK(buffer.reserve() == nullptr);
+	sample.timestamp = pushed;
+	CHECK(!buffer.push(sample));
+	CHECK(buffer.getDroppedCount() == 1);
+
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		const AS7341X_SAMPLE* slot = buffer.peek();
+		CHECK(slot != nullptr && slot->timestamp == popped++);
+		buffer.release();
+	}
+	CHECK(buffer.available() == 0);
+	CHECK(!buffer.pop(sample));
+
+	// clear() empties a partly filled buffer
+	CHECK(buffer.push(sample));
+	CHECK(buffer.push(sample));
+	buffer.clear();
+	CHECK(buffer.available() == 0);
+	CHECK(buffer.freeSpace() == 3);
+}
+
+// Sensor notified by the INT pin interrupt service routine of the threshold test
+static SparkFun_AS7341X* interruptTarget = nullptr;
+
+static void onInterruptPin()
+{
+	interruptTarget->notifyInterrupt();
+}
+
+static void testThresholdMonitoring()
+{
+	const uint8_t intPin = 2;
+	Board board;
+	board.sensor.setInterruptPin(intPin);
+	SparkFun_AS7341X as7341;
+	CHECK(beginAt1x(as7341));
+	interruptTarget = &as7341;
+	pinMode(intPin, INPUT_PULLUP);
+	attachInterrupt(digitalPinToInterrupt(intPin), onInterruptPin, FALLING);
+
+	// F1 reads 900, inside the window. Two cycles outside it are needed for an event.
+	CHECK(as7341.startThresholdMonitoring(0, 500, 1500, 2, 100));
+
+	// The sensor keeps measuring but nothing crosses the bus
+	Wire.resetStats();
+	uint32_t cycles = board.sensor.getCycles();
+	for (uint8_t i = 0; i < 100; i++)
+	{
+		CHECK(!as7341.updateThresholdMonitoring());
+		delay(10);
+	}
+	HostI2CStats stats;
+	Wire.getStats(stats);
+	CHECK(stats.transactions == 0);
+	CHECK(board.sensor.getCycles() - cycles >= 9);
+	AS7341X_SAMPLE sample;
+	CHECK(as7341.getThresholdEvent(sample) == AS7341X_THRESHOLD_EVENT::NONE);
+
+	// F1 triples to 2700 and the event carries the whole spectrum of that moment
+	board.sensor.setAmbient(0, 0.15f);
+	bool event = false;
+	unsigned long start = millis();
+	while (!event && millis() - start < 2000)
+	{
+		event = as7341.updateThresholdMonitoring();
+		if (!event)
+			delay(10);
+	}
+	CHECK(event);
+	CHECK(as7341.getThresholdEvent(sample) == AS7341X_THRESHOLD_EVENT::ABOVE);
+	CHECK(as7341.getThresholdEventCount() == 1);
+	static const uint8_t layout[12] = { 0, 1, 2, 3, 8, 9, 4, 5, 6, 7, 8, 9 };
+	for (uint8_t i = 0; i < 12; i++)
+		CHECK_NEAR(sample.channels[i], expectedCounts(layout[i], (layout[i] == 0) ? 3 : 1), 1);
+
+	// Monitoring resumed: the sensor is awake, measuring the F1 half again, and F1 is still above the window
+	CHECK(as7341.isThresholdMonitoringEnabled());
+	start = millis();
+	event = false;
+	while (!event && millis() - start < 2000)
+	{
+		event = as7341.updateThresholdMonitoring();
+		if (!event)
+			delay(10);
+	}
+	CHECK(event);
+	CHECK(as7341.getThresholdEventCount() == 2);
+
+	as7341.stopThresholdMonitoring();
+	detachInterrupt(digitalPinToInterrupt(intPin));
+	interruptTarget = nullptr;
+}
+
+// Basic counts (readAllChannelsBasicCounts layout) of a blackbody at kelvin seen through F1 to F8, modelled as
+// unit peak Gaussians with the datasheet peaks and FWHM. CLEAR and NIR are left at 0, the built-in matrix ignores them.
+static void blackbodyBasicCounts(double kelvin, float* basicCounts)
+{
+	static const double peak[8] = { 415, 445, 480, 515, 555, 590, 630, 680 };
+	static const double fwhm[8] = { 26, 30, 36, 39, 39, 40, 50, 52 };
+	static const uint8_t index[8] = { 0, 1, 2, 3, 6, 7, 8, 9 };
+
+	for (uint8_t i = 0; i < 12; i++)
+		basicCounts[i] = 0;
+	for (uint8_t f = 0; f < 8; f++)
+	{
+		double sigma = fwhm[f] / 2.3548;
+		double sum = 0;
+		for (int nm = 360; nm <= 830; nm++)
+		{
+			double lambda = nm * 1e-9;
+			double radiance = 1 / (pow(lambda, 5) * (exp(1.4388e-2 / (lambda * kelvin)) - 1));
+			sum += exp(-0.5 * pow((nm - peak[f]) / sigma, 2)) * radiance;
+		}
+		basicCounts[index[f]] = float(sum * 1e-14);
+	}
+}
+
+static void testColorimetry()
+{
+	SparkFun_AS7341X_Colorimetry colorimetry;
+
+	// Illuminant A and a 6500 K blackbody, against their CIE 1931 chromaticity
+	static const struct { double kelvin; double x; double y; } lights[] =
+	{
+		{ 2856, 0.4476, 0.4074 },
+		{ 6500, 0.3135, 0.3237 },
+	};
+	for (uint8_t l = 0; l < sizeof(lights) / sizeof(lights[0]); l++)
+	{
+		float basicCounts[12];
+		blackbodyBasicCounts(lights[l].kelvin, basicCounts);
+
+		AS7341X_COLOR color;
+		colorimetry.convert(basicCounts, color);
+		CHECK(color.Y > 0);
+		CHECK_NEAR(color.x, lights[l].x, 0.002);
+		CHECK_NEAR(color.y, lights[l].y, 0.002);
+		CHECK_NEAR(color.x, color.X / (color.X + color.Y + color.Z), 1e-6);
+		CHECK_NEAR(color.cct, lights[l].kelvin, 100);
+
+		// Lux follows Y and its scale, and calibration hits the reference
+		CHECK_NEAR(color.lux, color.Y, 1e-3 * color.Y);
+		CHECK(colorimetry.calibrateLux(basicCounts, 500));
+		colorimetry.convert(basicCounts, color);
+		CHECK_NEAR(color.lux, 500, 0.01);
+		colorimetry.resetMatrix();
+
+		// The batch path gives the same answer
+		static const uint8_t index[AS7341X_CHANNEL_COUNT] = { 0, 1, 2, 3, 6, 7, 8, 9, 10, 11 };
+		float X, Y, Z, x, y, lux, cct;
+		AS7341X_COLOR_BATCH batch = { {}, &X, &Y, &Z, &x, &y, &lux, &cct, 1 };
+		for (uint8_t c = 0; c < AS7341X_CHANNEL_COUNT; c++)
+			batch.channel[c] = &basicCounts[index[c]];
+		colorimetry.convert(batch);
+		colorimetry.convert(basicCounts, color);
+		CHECK_NEAR(X, color.X, 1e-4 * color.X);
+		CHECK_NEAR(y, color.y, 1e-5);
+		CHECK_NEAR(cct, color.cct, 0.5);
+	}
+
+	// Far from white light there is no CCT
+	float red[12] = {};
+	red[9] = 100;
+	AS7341X_COLOR color;
+	colorimetry.convert(red, color);
+	CHECK(color.cct == 0);
+}
+
+// A full two pass sample with distinct values in every field
+static AS7341X_SAMPLE frameSample()
+{
+	AS7341X_SAMPLE sample;
+	sample.timestamp = 0x12345678;
+	for (uint8_t i = 0; i < 12; i++)
+		sample.channels[i] = 1000 * (i + 1) + i;
+	sample.aStep = 599;
+	sample.aTime = 29;
+	sample.gain = 0x98;
+	sample.flags = AS7341X_SAMPLE_SATURATED_HIGH;
+	return sample;
+}
+
+static bool sameSample(const AS7341X_SAMPLE& a, const AS7341X_SAMPLE& b)
+{
+	for (uint8_t i = 0; i < 12; i++)
+		if (a.channels[i] != b.channels[i])
+			return false;
+	return a.timestamp == b.timestamp && a.aStep == b.aStep && a.aTime == b.aTime && a.gain == b.gain &&
+		a.flags == b.flags;
+}
+
+// Feeds a frame byte by byte. Returns how many samples it completed, the last one in sample.
+static uint8_t feedFrame(SparkFun_AS7341X_FrameDecoder& decoder, const byte* frame, byte length, AS7341X_SAMPLE& sample)
+{
+	uint8_t decoded = 0;
+	for (byte i = 0; i < length; i++)
+		if (decoder.decode(frame[i], sample))
+			decoded++;
+	return decoded;
+}
+
+static void testFrames()
+{
+	SparkFun_AS7341X_FrameEncoder encoder;
+	SparkFun_AS7341X_FrameDecoder decoder;
+	byte frame[AS7341X_FRAME_MAX_LENGTH];
+	AS7341X_SAMPLE decoded;
+
+	// Key frame: every field comes back
+	AS7341X_SAMPLE key = frameSample();
+	byte length = encoder.encode(key, frame);
+	CHECK(length == AS7341X_FRAME_MAX_LENGTH);
+	CHECK((frame[2] & 0x0f) == AS7341X_FRAME_KEY);
+	CHECK(feedFrame(decoder, frame, length, decoded) == 1);
+	CHECK(sameSample(decoded, key));
+	CHECK(decoder.getSequence() == 0);
+
+	// Delta frame: small steps both ways, applied on top of the key frame
+	AS7341X_SAMPLE next = key;
+	next.timestamp += 50000;
+	next.channels[0] += 3;
+	next.channels[11] -= 70;
+	next.flags = 0;
+	length = encoder.encode(next, frame);
+	CHECK((frame[2] & 0x0f) == AS7341X_FRAME_DELTA);
+	// Header, sequence, 3 byte timestamp step, flags, 12 one byte channel steps but one of 2 bytes, CRC
+	CHECK(length == 4 + 2 + 3 + 1 + 13 + 2);
+	CHECK(feedFrame(decoder, frame, length, decoded) == 1);
+	CHECK(sameSample(decoded, next));
+	CHECK(decoder.getSequence() == 1);
+	CHECK(decoder.getErrorCount() == 0);
+
+	// A corrupted payload byte fails the CRC and the frame is dropped
+	encoder.setDeltaEncoding(false);
+	length = encoder.encode(key, frame);
+	frame[10] ^= 0x01;
+	CHECK(feedFrame(decoder, frame, length, decoded) == 0);
+	CHECK(decoder.getErrorCount() == 1);
+
+	// Garbage, including a stray sync byte and a bad header, then the decoder picks up the next frame
+	static const byte garbage[] = { 0x00, 0xa5, 0x13, 0xa5, 0x5a, 0xf0, 0x07, 0xff, 0x5a };
+	CHECK(feedFrame(decoder, garbage, sizeof(garbage), decoded) == 0);
+	CHECK(decoder.getErrorCount() == 2);
+	key.timestamp += 100000;
+	key.channels[5] = 0xffff;
+	length = encoder.encode(key, frame);
+	CHECK(feedFrame(decoder, frame, length, decoded) == 1);
+	CHECK(sameSample(decoded, key));
+	CHECK(decoder.getSequence() == 3);
+}
+
+int main()
+{
+	struct Test
+	{
+		const char* name;
+		void (*run)();
+	};
+
+	static const Test tests[] =
+	{
+		{ "begin", testBegin },
+		{ "missing device", testMissingDevice },
+		{ "readAllChannels", testReadAllChannels },
+		{ "fixed point basic counts", testFixedBasicCounts },
+		{ "single channels", testSingleChannels },
+		{ "readChannels", testReadChannels },
+		{ "automatic gain", testAutomaticGain },
+		{ "LEDs", testLeds },
+		{ "differential", testDifferential },
+		{ "flicker", testFlicker },
+		{ "waveform during background detection", testWaveformDuringBackgroundDetection },
+		{ "FIFO drain", testFifoDrain },
+		{ "continuous measurement", testContinuousMeasurement },
+		{ "low power scheduler", testLowPowerScheduler },
+		{ "low power scheduler, sensor timed", testLowPowerSensorTimed },
+		{ "manager", testManager },
+		{ "auto exposure shortens integration", testAutoExposureShortensIntegration },
+		{ "auto exposure out of range", testAutoExposureOutOfRange },
+		{ "sample buffer", testSampleBuffer },
+		{ "threshold monitoring", testThresholdMonitoring },
+		{ "colorimetry", testColorimetry },
+		{ "frames", testFrames },
+	};
+
+	for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+	{
+		int before = failures;
+		tests[i].run();
+		printf("%s %s\n", (failures == before) ? "PASS" : "FAIL", tests[i].name);
+	}
+
+	return (failures == 0) ? 0 : 1;
+}
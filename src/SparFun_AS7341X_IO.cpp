@@ -23,13 +23,17 @@ bool SparkFun_AS7341X_IO::begin(byte AS7341X_address, TwoWire& wirePort)
 {
 	_i2cPort = &wirePort;
 	_address = AS7341X_address;
+	resyncShadowRegisters();
+#if AS7341X_IO_STATS
+	resetStats();
+#endif
 	return isConnected();
 }
 
 bool SparkFun_AS7341X_IO::isConnected()
 {
 	_i2cPort->beginTransmission(_address);
-	if (_i2cPort->endTransmission() != 0)
+	if (endWrite(0) != 0)
 		return (false);
 	return (true); 
 }
@@ -42,7 +46,14 @@ void SparkFun_AS7341X_IO::writeMultipleBytes(byte registerAddress, const byte* b
 	for (byte i = 0; i < packetLength; i++) 
 		_i2cPort->write(buffer[i]);
 	
-	_i2cPort->endTransmission();
+	endWrite(packetLength + 1);
+	
+	for (byte i = 0; i < packetLength; i++)
+		updateShadow(registerAddress + i, buffer[i]);
+	
+	// A burst running over CFG_0 may have changed the selected bank
+	if (registerAddress <= REGISTER_CFG_0 && registerAddress + packetLength > REGISTER_CFG_0)
+		invalidateBankCache();
 }
 
 void SparkFun_AS7341X_IO::readMultipleBytes(byte registerAddress, byte* buffer, byte const packetLength)
@@ -50,33 +61,46 @@ void SparkFun_AS7341X_IO::readMultipleBytes(byte registerAddress, byte* buffer,
 	setBankConfiguration(registerAddress);
 	_i2cPort->beginTransmission(_address);
 	_i2cPort->write(registerAddress);
-	_i2cPort->endTransmission();
+	endWrite(1);
 
-	_i2cPort->requestFrom(_address, packetLength);
+	requestRead(packetLength);
 	for (byte i = 0; (i < packetLength) && _i2cPort->available(); i++)
+	{
 		buffer[i] = _i2cPort->read();
-
+		updateShadow(registerAddress + i, buffer[i]);
+	}
 }
 
 byte SparkFun_AS7341X_IO::readSingleByte(byte registerAddress)
 {	
+	int8_t index = shadowIndex(registerAddress);
+	if (index >= 0 && (_shadowValid & (1 << index)))
+		return _shadowValue[index];
+	
+	return fetchSingleByte(registerAddress);
+}
+
+byte SparkFun_AS7341X_IO::fetchSingleByte(byte registerAddress)
+{
 	setBankConfiguration(registerAddress);
-	byte result;
-	_i2cPort->beginTransmission(_address);
-	_i2cPort->write(registerAddress);
-	_i2cPort->endTransmission();
-	_i2cPort->requestFrom(_address, 1U);
-	result = _i2cPort->read();
+	byte result = readByteFromBus(registerAddress);
+	trackConfig0(registerAddress, result);
+	updateShadow(registerAddress, result);
 	return result;
 }
 
 void SparkFun_AS7341X_IO::writeSingleByte(byte registerAddress, byte const value)
 {	
+	// Skip the bus entirely if the device already holds this value. SMUXEN is a command bit and is never skipped.
+	int8_t index = shadowIndex(registerAddress);
+	bool isCommand = (registerAddress == REGISTER_ENABLE) && (value & (1 << 4));
+	if (index >= 0 && !isCommand && (_shadowValid & (1 << index)) && _shadowValue[index] == value)
+		return;
+	
 	setBankConfiguration(registerAddress);
-	_i2cPort->beginTransmission(_address);
-	_i2cPort->write(registerAddress);
-	_i2cPort->write(value);
-	_i2cPort->endTransmission();
+	writeByteToBus(registerAddress, value);
+	trackConfig0(registerAddress, value);
+	updateShadow(registerAddress, value);
 }
 
 void SparkFun_AS7341X_IO::setRegisterBit(byte registerAddress, byte const bitPosition)
@@ -103,24 +127,192 @@ bool SparkFun_AS7341X_IO::isBitSet(byte registerAddress, byte const bitPosition)
 		return false;
 }
 
+void SparkFun_AS7341X_IO::invalidateBankCache()
+{
+	_cfg0Valid = false;
+}
+
+void SparkFun_AS7341X_IO::resyncShadowRegisters()
+{
+	_shadowValid = 0;
+	invalidateBankCache();
+}
+
+void SparkFun_AS7341X_IO::setShadowVolatile(byte registerAddress, bool isVolatile)
+{
+	int8_t index = shadowIndex(registerAddress);
+	if (index < 0)
+		return;
+	
+	if (isVolatile)
+	{
+		_shadowVolatile |= (1 << index);
+		_shadowValid &= ~(1 << index);
+	}
+	else
+		_shadowVolatile &= ~(1 << index);
+}
+
+int8_t SparkFun_AS7341X_IO::shadowIndex(byte registerAddress)
+{
+	switch (registerAddress)
+	{
+	case REGISTER_ENABLE:
+		return 0;
+	case REGISTER_ATIME:
+		return 1;
+	case REGISTER_ASTEP_L:
+		return 2;
+	case REGISTER_ASTEP_H:
+		return 3;
+	case REGISTER_CFG_1:
+		return 4;
+	case REGISTER_LED:
+		return 5;
+	case REGISTER_INTENAB:
+		return 6;
+	case REGISTER_PERS:
+		return 7;
+	case REGISTER_CFG_9:
+		return 8;
+	default:
+		return -1;
+	}
+}
+
+void SparkFun_AS7341X_IO::updateShadow(byte registerAddress, byte value)
+{
+	int8_t index = shadowIndex(registerAddress);
+	if (index < 0 || (_shadowVolatile & (1 << index)))
+		return;
+	
+	// SMUXEN clears itself once the SMUX command completes, so never remember it as set
+	if (registerAddress == REGISTER_ENABLE)
+		value &= ~(1 << 4);
+	
+	_shadowValue[index] = value;
+	_shadowValid |= (1 << index);
+}
+
 void SparkFun_AS7341X_IO::setBankConfiguration(byte regAddress)
 {
-	byte result;
-	_i2cPort->beginTransmission(_address);
-	_i2cPort->write(REGISTER_CFG_0);
-	_i2cPort->endTransmission();
-	_i2cPort->requestFrom(_address, 1U);
-	result = _i2cPort->read();
+	// CFG_0 is reachable from both banks
+	if (regAddress == REGISTER_CFG_0)
+		return;
+	
+	// Registers 0x60 to 0x74 live in bank 1, everything else in bank 0
+	bool highBank = (regAddress >= 0x60 && regAddress <= 0x74);
+	
+	// Only read CFG_0 back when we have lost track of it
+	if (!_cfg0Valid)
+	{
+		_cfg0 = readByteFromBus(REGISTER_CFG_0);
+		_cfg0Valid = true;
+	}
 	
-	byte value;
+	bool bankSelected = (_cfg0 & (1 << 4)) != 0;
+	if (bankSelected == highBank)
+		return;
 	
-	if (regAddress >= 0x60 && regAddress <= 0x74)
-		value |= (1 << 4);
+	if (highBank)
+		_cfg0 |= (1 << 4);
 	else
-		value &= ~(1 << 4);
+		_cfg0 &= ~(1 << 4);
+
+	writeByteToBus(REGISTER_CFG_0, _cfg0);
+#if AS7341X_IO_STATS
+	_stats.bankSwitches++;
+	_siteStats[byte(_site)].bankSwitches++;
+#endif
+}
+
+void SparkFun_AS7341X_IO::trackConfig0(byte registerAddress, byte value)
+{
+	if (registerAddress != REGISTER_CFG_0)
+		return;
+	_cfg0 = value;
+	_cfg0Valid = true;
+}
+
+byte SparkFun_AS7341X_IO::readByteFromBus(byte registerAddress)
+{
+	_i2cPort->beginTransmission(_address);
+	_i2cPort->write(registerAddress);
+	endWrite(1);
+	requestRead(1);
+	return _i2cPort->read();
+}
 
+void SparkFun_AS7341X_IO::writeByteToBus(byte registerAddress, byte value)
+{
 	_i2cPort->beginTransmission(_address);
-	_i2cPort->write(REGISTER_CFG_0);
+	_i2cPort->write(registerAddress);
 	_i2cPort->write(value);
-	_i2cPort->endTransmission();
-}
\ No newline at end of file
+	endWrite(2);
+}
+
+byte SparkFun_AS7341X_IO::endWrite(byte bytesWritten)
+{
+#if AS7341X_IO_STATS
+	unsigned long start = micros();
+	byte result = _i2cPort->endTransmission();
+	countTransaction(bytesWritten, 0, result != 0, micros() - start);
+	return result;
+#else
+	(void)bytesWritten;
+	return _i2cPort->endTransmission();
+#endif
+}
+
+byte SparkFun_AS7341X_IO::requestRead(byte packetLength)
+{
+#if AS7341X_IO_STATS
+	unsigned long start = micros();
+	byte received = _i2cPort->requestFrom(_address, packetLength);
+	countTransaction(0, received, received != packetLength, micros() - start);
+	return received;
+#else
+	return _i2cPort->requestFrom(_address, packetLength);
+#endif
+}
+
+#if AS7341X_IO_STATS
+void SparkFun_AS7341X_IO::countTransaction(byte bytesWritten, byte bytesRead, bool nack, unsigned long elapsed)
+{
+	SparkFun_AS7341X_IOStats* counters[2] = { &_stats, &_siteStats[byte(_site)] };
+	for (byte i = 0; i < 2; i++)
+	{
+		counters[i]->transactions++;
+		counters[i]->bytesWritten += bytesWritten;
+		counters[i]->bytesRead += bytesRead;
+		counters[i]->busMicros += elapsed;
+		if (nack)
+			counters[i]->nacks++;
+	}
+}
+
+void SparkFun_AS7341X_IO::getStats(SparkFun_AS7341X_IOStats& stats)
+{
+	stats = _stats;
+}
+
+void SparkFun_AS7341X_IO::getStats(AS7341X_IO_SITE site, SparkFun_AS7341X_IOStats& stats)
+{
+	if (site >= AS7341X_IO_SITE::COUNT)
+		site = AS7341X_IO_SITE::OTHER;
+	stats = _siteStats[byte(site)];
+}
+
+void SparkFun_AS7341X_IO::resetStats()
+{
+	memset(&_stats, 0, sizeof(_stats));
+	memset(_siteStats, 0, sizeof(_siteStats));
+}
+
+AS7341X_IO_SITE SparkFun_AS7341X_IO::setSite(AS7341X_IO_SITE site)
+{
+	AS7341X_IO_SITE previous = _site;
+	_site = site;
+	return previous;
+}
+#endif
\ No newline at end of file
@@ -21,13 +21,94 @@
 #include "SparkFun_AS7341X_IO.h"
 #include "SparkFun_AS7341X_Arduino_Library.h"
 
+// SMUX RAM images (registers 0x00 to 0x13), generated at compile time from the photodiode routes. Stored in flash
+// and written in a single burst. The low and high images match AMS application note V1.1.
+typedef AS7341X_PHOTODIODE PD;
+typedef SparkFun_AS7341X_Smux Smux;
+
+// F1, F2, F3, F4, Clear and NIR to ADC0 through ADC5
+static const byte smuxLowChannels[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(
+	Smux::route(PD::F1, 0), Smux::route(PD::F2, 1), Smux::route(PD::F3, 2),
+	Smux::route(PD::F4, 3), Smux::route(PD::CLEAR, 4), Smux::route(PD::NIR, 5));
+
+// F5, F6, F7, F8, Clear and NIR to ADC0 through ADC5
+static const byte smuxHighChannels[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(
+	Smux::route(PD::F5, 0), Smux::route(PD::F6, 1), Smux::route(PD::F7, 2),
+	Smux::route(PD::F8, 3), Smux::route(PD::CLEAR, 4), Smux::route(PD::NIR, 5));
+
+// F1 -> ADC0
+static const byte smux415nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F1, 0));
+
+// F2 -> ADC0
+static const byte smux445nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F2, 0));
+
+// F3 -> ADC0
+static const byte smux480nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F3, 0));
+
+// F4 -> ADC0
+static const byte smux515nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F4, 0));
+
+// F5 -> ADC0
+static const byte smux555nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F5, 0));
+
+// F6 -> ADC0
+static const byte smux590nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F6, 0));
+
+// F7 -> ADC0
+static const byte smux630nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F7, 0));
+
+// F8 -> ADC0
+static const byte smux680nm[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::F8, 0));
+
+// Clear -> ADC0
+static const byte smuxClear[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::CLEAR, 0));
+
+// NIR -> ADC0
+static const byte smuxNIR[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::NIR, 0));
+
+// Flicker photodiode -> flicker detection engine (ADC5)
+static const byte smuxFlicker[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(Smux::route(PD::FLICKER, 5));
+
+// Photodiodes of each optical channel (F1 to F8, Clear, NIR) for images built at run time
+static const byte smuxPixelMap[AS7341X_CHANNEL_COUNT][2] PROGMEM =
+{
+	{ Smux::pixel(PD::F1, 0), Smux::pixel(PD::F1, 1) },
+	{ Smux::pixel(PD::F2, 0), Smux::pixel(PD::F2, 1) },
+	{ Smux::pixel(PD::F3, 0), Smux::pixel(PD::F3, 1) },
+	{ Smux::pixel(PD::F4, 0), Smux::pixel(PD::F4, 1) },
+	{ Smux::pixel(PD::F5, 0), Smux::pixel(PD::F5, 1) },
+	{ Smux::pixel(PD::F6, 0), Smux::pixel(PD::F6, 1) },
+	{ Smux::pixel(PD::F7, 0), Smux::pixel(PD::F7, 1) },
+	{ Smux::pixel(PD::F8, 0), Smux::pixel(PD::F8, 1) },
+	{ Smux::pixel(PD::CLEAR, 0), Smux::pixel(PD::CLEAR, 1) },
+	{ Smux::pixel(PD::NIR, 0), Smux::pixel(PD::NIR, 1) }
+};
+
+// Turns an FD_STATUS value into 100 or 120 (Hz), or 0 if no known flicker was detected
+static int flickerFrequencyFromStatus(byte flickerStatus)
+{
+	// FD_100HZ_FLICKER and FD_120HZ_FLICKER only count along with their valid flags (bits 2 and 3)
+	bool is100Hz = (flickerStatus & 0x05) == 0x05;
+	bool is120Hz = (flickerStatus & 0x0a) == 0x0a;
+	
+	if (is100Hz && !is120Hz)
+		return 100;
+	
+	if (is120Hz && !is100Hz)
+		return 120;
+	
+	return 0;
+}
+
 SparkFun_AS7341X::SparkFun_AS7341X(AS7341X_DEVICE deviceUsed)
 {
 	device = deviceUsed;
 }
 
 bool SparkFun_AS7341X::begin(byte AS7341X_address, TwoWire& wirePort)
-{	
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::BEGIN);
+	
 	// Reset error variable
 	lastError = ERROR_NONE;
 	
@@ -163,7 +244,7 @@ void SparkFun_AS7341X::setLedDrive(unsigned int current)
 	// Update bits 6:0 accordingly
 	currentValue |= registerValue;
 	// Write register back
-	as7341_io.writeSingleByte(REGISTER_LED, registerValue);
+	as7341_io.writeSingleByte(REGISTER_LED, currentValue);
 }
 
 unsigned int SparkFun_AS7341X::getLedDrive()
@@ -175,11 +256,13 @@ unsigned int SparkFun_AS7341X::getLedDrive()
 
 void SparkFun_AS7341X::setATIME(byte aTime /* = 29 */)
 {
+	invalidateBasicCountScale();
 	as7341_io.writeSingleByte(REGISTER_ATIME, aTime);
 }
 
 void SparkFun_AS7341X::setASTEP(unsigned int aStep /* = 599 */)
 {
+	invalidateBasicCountScale();
 	byte temp = byte(aStep >> 8);
 	as7341_io.writeSingleByte(REGISTER_ASTEP_H, temp);
 	temp = byte(aStep &= 0xff);
@@ -261,7 +344,11 @@ void SparkFun_AS7341X::setGain(AS7341X_GAIN gain)
 AS7341X_GAIN SparkFun_AS7341X::getGain()
 {
 	byte value = as7341_io.readSingleByte(REGISTER_CFG_1);
-	value &= 0x1f;
+	return gainFromCode(value & 0x1f);
+}
+
+AS7341X_GAIN SparkFun_AS7341X::gainFromCode(byte value)
+{
 	AS7341X_GAIN returnValue;
 	
 	switch (value)
@@ -318,582 +405,1122 @@ AS7341X_GAIN SparkFun_AS7341X::getGain()
 	return returnValue;
 }
 
-bool SparkFun_AS7341X::readAllChannels(unsigned int* channelData)
+float SparkFun_AS7341X::getBasicCountScale(byte gainCode)
 {
-	lastError = ERROR_NONE;
+	if (gainCode == basicCountGain)
+		return basicCountScale;
 	
-	byte channelDataLength = sizeof(channelData) / sizeof(channelData[0]);
-	setMuxLo();
-	delay(5);
-	as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
+	if (!tintReciprocalValid)
+	{
+		// tint = (ATIME + 1) x (ASTEP + 1) x 2.78 us, in milliseconds. See AN000633, page 7.
+		unsigned long steps = (unsigned long)(getATIME() + 1) * ((unsigned long)getASTEP() + 1);
+		tintReciprocal = 1.0f / (steps * 0.00278f);
+		tintReciprocalValid = true;
+	}
 	
-	unsigned int start = millis();
-	unsigned int delta = 0;
+	// AGAIN code 0 is 0.5x and every code doubles the gain, so halve the scale once per code
+	float scale = tintReciprocal * 2.0f;
+	for (byte i = 0; i < gainCode; i++)
+		scale *= 0.5f;
 	
-	do
+	basicCountScale = scale;
+	basicCountGain = gainCode;
+	return basicCountScale;
+}
+
+void SparkFun_AS7341X::invalidateBasicCountScale()
+{
+	tintReciprocalValid = false;
+	basicCountGain = 0xff;
+	fixedBasicCountValid = false;
+}
+
+uint32_t SparkFun_AS7341X::convertBasicCountFixed(uint16_t raw, byte gainCode)
+{
+	if (!fixedBasicCountValid)
 	{
-		delta = millis();
-		if (delta - start > 5000)
-		{
-			lastError = ERROR_AS7341X_MEASUREMENT_TIMEOUT;
-			return false;
-		}
-	} while (!as7341_io.isBitSet(REGISTER_STATUS_2, 6));
-	
-	byte buffer[12];
+		// raw / (gain * tint) with tint = steps * 278 / 100000 ms, scaled by 2^16 for Q16.16. The factor is
+		// kept as large as 32 bits allow, and shift remembers by how much it was scaled up.
+		uint64_t steps = (uint64_t)(getATIME() + 1) * ((uint64_t)getASTEP() + 1);
+		uint64_t numerator = 100000ULL << 16;
+		uint64_t denominator = steps * 278;
+		byte shift = 0;
+		while (shift < 31 && ((numerator << (shift + 1)) / denominator) <= 0xffffffffULL)
+			shift++;
 		
-	as7341_io.readMultipleBytes(REGISTER_CH0_DATA_L, buffer, 12);
+		fixedBasicCountFactor = (uint32_t)((numerator << shift) / denominator);
+		fixedBasicCountShift = shift;
+		fixedBasicCountValid = true;
+	}
 	
-	for (int i = 0; i < 6; i++)
-		channelData[i] = buffer[2*i + 1] << 8 | buffer[2*i];
+	// Gain is 2^(code - 1), so it is applied as a shift. The factor is always scaled by at least 2^7.
+	uint64_t value = ((uint64_t)raw * fixedBasicCountFactor) >> (fixedBasicCountShift + gainCode - 1);
+	if (value > 0xffffffffULL)
+		return 0xffffffff;
 	
-	setMuxHi();
-	delay(5);
-	as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
-	start = millis();
-	delta = 0;
-	do
-	{
-		delta = millis();
-		if (delta - start > 5000)
-		{
-			lastError = ERROR_AS7341X_MEASUREMENT_TIMEOUT;
-			return false;
-		}
-	} while (!as7341_io.isBitSet(REGISTER_STATUS_2, 6));
+	return (uint32_t)value;
+}
+
+void SparkFun_AS7341X::enableAutomaticGain(AS7341X_GAIN maxGain, AS7341X_AGC_LOW_HYSTERESIS lowHysteresis, AS7341X_AGC_HIGH_HYSTERESIS highHysteresis)
+{
+	if (maxGain == AS7341X_GAIN::GAIN_INVALID)
+		maxGain = AS7341X_GAIN::GAIN_X256;
 	
-	as7341_io.readMultipleBytes(REGISTER_CH0_DATA_L, buffer, 12);
+	// AGAIN codes follow the enumeration order, 0 (0.5x) to 10 (512x)
+	byte value = as7341_io.readSingleByte(REGISTER_AGC_GAIN_MAX);
+	value = (value & 0xf0) | byte(maxGain);
+	as7341_io.writeSingleByte(REGISTER_AGC_GAIN_MAX, value);
 	
-	for (int i = 0; i < 6; i++)
-		channelData[i + 6] = buffer[2*i + 1] << 8 | buffer[2*i];
+	value = as7341_io.readSingleByte(REGISTER_CFG_10);
+	value = (value & 0x0f) | (byte(highHysteresis) << 6) | (byte(lowHysteresis) << 4);
+	as7341_io.writeSingleByte(REGISTER_CFG_10, value);
 	
-	return true;
+	// From now on the sensor rewrites CFG_1 by itself, so it can't be trusted from the shadow
+	as7341_io.setShadowVolatile(REGISTER_CFG_1, true);
+	as7341_io.setRegisterBit(REGISTER_CFG_8, 2);
+	agcEnabled = true;
 }
 
-void SparkFun_AS7341X::setMuxLo()
+void SparkFun_AS7341X::disableAutomaticGain()
 {
-	// According to AMS application note V1.1
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x30);
-	as7341_io.writeSingleByte(0x01, 0x01);
-	as7341_io.writeSingleByte(0x02, 0x00);
-	as7341_io.writeSingleByte(0x03, 0x00);
-	as7341_io.writeSingleByte(0x04, 0x00);
-	as7341_io.writeSingleByte(0x05, 0x42);
-	as7341_io.writeSingleByte(0x06, 0x00);
-	as7341_io.writeSingleByte(0x07, 0x00);
-	as7341_io.writeSingleByte(0x08, 0x50);
-	as7341_io.writeSingleByte(0x09, 0x00);
-	as7341_io.writeSingleByte(0x0a, 0x00);
-	as7341_io.writeSingleByte(0x0b, 0x00);
-	as7341_io.writeSingleByte(0x0c, 0x20);
-	as7341_io.writeSingleByte(0x0d, 0x04);
-	as7341_io.writeSingleByte(0x0e, 0x00);
-	as7341_io.writeSingleByte(0x0f, 0x30);
-	as7341_io.writeSingleByte(0x10, 0x01);
-	as7341_io.writeSingleByte(0x11, 0x50);
-	as7341_io.writeSingleByte(0x12, 0x00);
-	as7341_io.writeSingleByte(0x13, 0x06);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
+	as7341_io.clearRegisterBit(REGISTER_CFG_8, 2);
+	agcEnabled = false;
+	as7341_io.setShadowVolatile(REGISTER_CFG_1, false);
 }
 
-void SparkFun_AS7341X::setMuxHi()
+bool SparkFun_AS7341X::isAutomaticGainEnabled()
 {
-	// According to AMS application note V1.1
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x00, 0x00);
-	as7341_io.writeSingleByte(0x01, 0x00);
-	as7341_io.writeSingleByte(0x02, 0x00);
-	as7341_io.writeSingleByte(0x03, 0x40);
-	as7341_io.writeSingleByte(0x04, 0x02);
-	as7341_io.writeSingleByte(0x05, 0x00);
-	as7341_io.writeSingleByte(0x06, 0x10);
-	as7341_io.writeSingleByte(0x07, 0x03);
-	as7341_io.writeSingleByte(0x08, 0x50);
-	as7341_io.writeSingleByte(0x09, 0x10);
-	as7341_io.writeSingleByte(0x0a, 0x03);
-	as7341_io.writeSingleByte(0x0b, 0x00);
-	as7341_io.writeSingleByte(0x0c, 0x00);
-	as7341_io.writeSingleByte(0x0d, 0x00);
-	as7341_io.writeSingleByte(0x0e, 0x24);
-	as7341_io.writeSingleByte(0x0f, 0x00);
-	as7341_io.writeSingleByte(0x10, 0x00);
-	as7341_io.writeSingleByte(0x11, 0x50);
-	as7341_io.writeSingleByte(0x12, 0x00);
-	as7341_io.writeSingleByte(0x13, 0x06);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
+	return agcEnabled;
 }
 
-bool SparkFun_AS7341X::readAllChannelsBasicCounts(float* channelDataBasicCounts)
+AS7341X_GAIN SparkFun_AS7341X::getMeasurementGain(byte pass)
 {
-	lastError = ERROR_NONE;
+	if (pass > 1)
+		return AS7341X_GAIN::GAIN_INVALID;
 	
-	unsigned int rawChannelData[12];
-	bool result = readAllChannels(rawChannelData);
+	return gainFromCode(passAStatus[pass] & 0x0f);
+}
+
+bool SparkFun_AS7341X::isMeasurementSaturated(byte pass)
+{
+	if (pass > 1)
+		return false;
 	
-	if (result == false)
+	return (passAStatus[pass] & 0x80) != 0;
+}
+
+bool SparkFun_AS7341X::readAllChannels(unsigned int* channelData)
+{
+	if (!startMeasurement())
 		return false;
 	
-	unsigned int aTime = (unsigned int) getATIME();
-	unsigned int aStep = getASTEP();
-	unsigned int tint = (aTime + 1) * (aStep * 1) * 2.78 / 1000;
+	while (!poll())
+	{
+		if (measurementState == AS7341X_MEASUREMENT_STATE::ERROR)
+			return false;
 		
-	byte value = as7341_io.readSingleByte(REGISTER_CFG_1);
-	value &= 0x1f;
+		// Once the integration is due, STATUS_2 is read at most every STATUS_POLL_INTERVAL_US
+		if (measurementState == AS7341X_MEASUREMENT_STATE::INTEGRATING_LOW ||
+			measurementState == AS7341X_MEASUREMENT_STATE::INTEGRATING_HIGH)
+			delayMicroseconds(STATUS_POLL_INTERVAL_US);
+	}
+	
+	return getResult(channelData);
+}
 
-	float gain;
-	if (value == 0)
+bool SparkFun_AS7341X::readAllChannelsDifferential(AS7341X_LED led, unsigned int* channelData, unsigned int* ambientData)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::READ_ALL_CHANNELS);
+	
+	lastError = ERROR_NONE;
+	
+	// Select the LED on the PCA9536 once, from then on only LED_ACT is toggled
+	bool ledWasPowered = (led == AS7341X_LED::IR) ? IRLedPowered : whiteLedPowered;
+	byte ledGpio = (led == AS7341X_LED::IR) ? IR_LED_GPIO : WHITE_LED_GPIO;
+	pca9536_io.write(ledGpio, LOW);
+	
+	uint16_t ambient[12];
+	uint16_t lit[12];
+	bool result;
+	
+	// Pass status comes from the LED on reading, with saturation in either reading since it spoils the difference
+	setMuxLo();
+	result = integrateWithLed(false, ambient);
+	byte ambientStatus = lastAStatus;
+	result = result && integrateWithLed(true, lit);
+	passAStatus[0] = lastAStatus | (ambientStatus & 0x80);
+	
+	if (result)
 	{
-		gain = 0.5f;
+		setMuxHi();
+		result = integrateWithLed(true, lit + 6);
+		passAStatus[1] = lastAStatus;
+		result = result && integrateWithLed(false, ambient + 6);
+		passAStatus[1] |= lastAStatus & 0x80;
 	}
+	
+	// Put the LEDs back the way they were
+	if (whiteLedPowered || IRLedPowered)
+		as7341_io.setRegisterBit(REGISTER_LED, 7);
 	else
-	{
-		gain = pow(2, (value - 1));
-	}
+		as7341_io.clearRegisterBit(REGISTER_LED, 7);
+	if (!ledWasPowered)
+		pca9536_io.write(ledGpio, HIGH);
 	
-	for (int i = 0; i < 12; i++)
+	if (!result)
+		return false;
+	
+	for (byte i = 0; i < 12; i++)
 	{
-		channelDataBasicCounts[i] = float(rawChannelData[i]) / (gain * tint);
+		channelData[i] = (lit[i] > ambient[i]) ? lit[i] - ambient[i] : 0;
+		if (ambientData != nullptr)
+			ambientData[i] = ambient[i];
 	}
 	
 	return true;
 }
 
-void SparkFun_AS7341X::enablePinInterupt()
+bool SparkFun_AS7341X::integrateWithLed(bool ledOn, uint16_t* adcData)
 {
-	as7341_io.setRegisterBit(REGISTER_INTENAB, 0);
+	// Stop the engine so the next integration starts with the LED already in its new state
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 1);
+	if (ledOn)
+		as7341_io.setRegisterBit(REGISTER_LED, 7);
+	else
+		as7341_io.clearRegisterBit(REGISTER_LED, 7);
+	
+	return integrateAdcs(adcData);
 }
 
-void SparkFun_AS7341X::disablePinInterrupt()
+bool SparkFun_AS7341X::startMeasurement()
 {
-	as7341_io.clearRegisterBit(REGISTER_INTENAB, 0);
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::READ_ALL_CHANNELS);
+	
+	lastError = ERROR_NONE;
+	
+	setMuxLo();
+	measurementState = AS7341X_MEASUREMENT_STATE::SMUX_LOW;
+	measurementStepStart = millis();
+	return true;
 }
 
-void SparkFun_AS7341X::clearPinInterrupt()
+bool SparkFun_AS7341X::poll()
 {
-	as7341_io.writeSingleByte(REGISTER_STATUS, 0xff);
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::READ_ALL_CHANNELS);
+	
+	// In interrupt mode the bus is left alone until the INT pin tells us something happened
+	byte status = 0;
+	bool measuring = (measurementState != AS7341X_MEASUREMENT_STATE::IDLE) &&
+		(measurementState != AS7341X_MEASUREMENT_STATE::READY) &&
+		(measurementState != AS7341X_MEASUREMENT_STATE::ERROR);
+	if (interruptDriven && measuring)
+	{
+		status = takeInterruptStatus();
+		if (status == 0)
+		{
+			measurementStepTimedOut();
+			return false;
+		}
+	}
+	
+	switch (measurementState)
+	{
+	case AS7341X_MEASUREMENT_STATE::SMUX_LOW:
+	case AS7341X_MEASUREMENT_STATE::SMUX_HIGH:
+		if (measurementStepTimedOut())
+			return false;
+		
+		if (interruptDriven)
+		{
+			// SINT flags the end of the SMUX command
+			if ((status & 0x01) == 0)
+				return false;
+		}
+		else if (!isSmuxDone())
+			return false;
+		
+		// SMUX is configured, start integrating
+		as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
+		integrationStart = micros();
+		if (measurementState == AS7341X_MEASUREMENT_STATE::SMUX_LOW)
+			measurementState = AS7341X_MEASUREMENT_STATE::INTEGRATING_LOW;
+		else
+			measurementState = AS7341X_MEASUREMENT_STATE::INTEGRATING_HIGH;
+		measurementStepStart = millis();
+		return false;
+		
+	case AS7341X_MEASUREMENT_STATE::INTEGRATING_LOW:
+	case AS7341X_MEASUREMENT_STATE::INTEGRATING_HIGH:
+		if (measurementStepTimedOut())
+			return false;
+		
+		if (interruptDriven)
+		{
+			// AINT fires on every spectral cycle since APERS is 0
+			if ((status & 0x08) == 0)
+				return false;
+		}
+		else if (micros() - integrationStart < getIntegrationMicros() || !as7341_io.isBitSet(REGISTER_STATUS_2, 6))
+		{
+			// No data can be valid before the integration time has elapsed, leave the bus alone until then
+			return false;
+		}
+		
+		if (measurementState == AS7341X_MEASUREMENT_STATE::INTEGRATING_LOW)
+		{
+			// Low half is done, switch SMUX over to the high half
+			passAStatus[0] = readAdcData(measurementData);
+			setMuxHi();
+			measurementState = AS7341X_MEASUREMENT_STATE::SMUX_HIGH;
+			measurementStepStart = millis();
+			return false;
+		}
+		
+		passAStatus[1] = readAdcData(measurementData + 6);
+		
+		// Stop the spectral engine so it does not keep pulling INT low every cycle
+		if (interruptDriven)
+			as7341_io.clearRegisterBit(REGISTER_ENABLE, 1);
+		
+		measurementState = AS7341X_MEASUREMENT_STATE::READY;
+		return true;
+		
+	case AS7341X_MEASUREMENT_STATE::READY:
+		return true;
+		
+	case AS7341X_MEASUREMENT_STATE::IDLE:
+	case AS7341X_MEASUREMENT_STATE::ERROR:
+	default:
+		return false;
+	}
 }
 
-byte SparkFun_AS7341X::readRegister(byte reg)
+bool SparkFun_AS7341X::isReady()
 {
-	return as7341_io.readSingleByte(reg);
+	return (measurementState == AS7341X_MEASUREMENT_STATE::READY);
 }
 
-void SparkFun_AS7341X::writeRegister(byte reg, byte value)
+AS7341X_MEASUREMENT_STATE SparkFun_AS7341X::getMeasurementState()
 {
-	as7341_io.writeSingleByte(reg, value);
+	return measurementState;
 }
 
-void SparkFun_AS7341X::setGpioPinInput()
+bool SparkFun_AS7341X::getResult(unsigned int* channelData)
 {
-	// Disable GPIO as output driver
-	as7341_io.setRegisterBit(REGISTER_GPIO_2, 1);
-	// Enable GPIO as input
-	as7341_io.setRegisterBit(REGISTER_GPIO_2, 2);
+	if (measurementState != AS7341X_MEASUREMENT_STATE::READY)
+		return false;
+	
+	for (int i = 0; i < 12; i++)
+		channelData[i] = measurementData[i];
+	
+	return true;
 }
 
-void SparkFun_AS7341X::setGpioPinOutput()
+bool SparkFun_AS7341X::getResult(AS7341X_SAMPLE& sample)
 {
-	// Disable GPIO input
-	as7341_io.clearRegisterBit(REGISTER_GPIO_2, 2);
+	if (measurementState != AS7341X_MEASUREMENT_STATE::READY)
+		return false;
+	
+	fillSample(sample, false);
+	return true;
 }
 
-bool SparkFun_AS7341X::digitalRead()
+void SparkFun_AS7341X::fillSample(AS7341X_SAMPLE& sample, bool singlePass)
 {
-	return as7341_io.isBitSet(REGISTER_GPIO_2, 0);
+	sample.timestamp = lastReadMicros;
+	sample.aTime = getATIME();
+	sample.aStep = getASTEP();
+	sample.gain = passAStatus[0] & 0x0f;
+	sample.flags = 0;
+	if (passAStatus[0] & 0x80)
+		sample.flags |= AS7341X_SAMPLE_SATURATED_LOW;
+	
+	byte channelCount = 6;
+	if (singlePass)
+		sample.flags |= AS7341X_SAMPLE_SINGLE_PASS;
+	else
+	{
+		channelCount = 12;
+		sample.gain |= (passAStatus[1] & 0x0f) << 4;
+		if (passAStatus[1] & 0x80)
+			sample.flags |= AS7341X_SAMPLE_SATURATED_HIGH;
+	}
+	
+	for (byte i = 0; i < 12; i++)
+		sample.channels[i] = (i < channelCount) ? measurementData[i] : 0;
 }
 
-void SparkFun_AS7341X::invertGpioOutput(bool isInverted)
+void SparkFun_AS7341X::enableInterruptDrivenMeasurements()
 {
-	if (isInverted)
-		as7341_io.setRegisterBit(REGISTER_GPIO_2, 3);
-	else
-		as7341_io.clearRegisterBit(REGISTER_GPIO_2, 3);
+	interruptPending = false;
+	interruptDriven = true;
+	
+	// Every spectral cycle raises AINT, SMUX completion raises SINT
+	setAPERS(0);
+	as7341_io.setRegisterBit(REGISTER_INTENAB, 3);
+	as7341_io.setRegisterBit(REGISTER_INTENAB, 0);
+	clearPinInterrupt();
 }
 
-void SparkFun_AS7341X::digitalWrite(byte value)
+void SparkFun_AS7341X::disableInterruptDrivenMeasurements()
 {
-	// If value is 0, let go the driver
-	if(value == 0)
-		as7341_io.clearRegisterBit(REGISTER_GPIO_2, 1);
-	else
-		as7341_io.setRegisterBit(REGISTER_GPIO_2, 1);
+	interruptDriven = false;
+	as7341_io.clearRegisterBit(REGISTER_INTENAB, 3);
 }
 
-uint16_t SparkFun_AS7341X::readSingleChannelValue()
+void SparkFun_AS7341X::notifyInterrupt()
 {
-	as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
-	
-	lastError = ERROR_NONE;
+	interruptPending = true;
+}
 
-	uint16_t start = millis();
-	uint16_t delta = 0;
-	
-	do
-	{
-		delta = millis();
-		if (delta - start > 5000)
-		{
-			lastError = ERROR_AS7341X_MEASUREMENT_TIMEOUT;
-			return 0;
-		}
-	} while (!as7341_io.isBitSet(REGISTER_STATUS_2, 6));
-	
-	byte buffer[2] = { 0 };
-	
-	as7341_io.readMultipleBytes(REGISTER_CH0_DATA_L, buffer, 2);
-	uint16_t result = buffer[1] << 8;
-	result += buffer[0];
+byte SparkFun_AS7341X::takeInterruptStatus()
+{
+	if (!interruptPending)
+		return 0;
+	interruptPending = false;
 	
-	return result;
+	// Read the interrupt sources and write them back to release the INT pin before the next event can arrive
+	byte status = as7341_io.readSingleByte(REGISTER_STATUS);
+	if (status != 0)
+		as7341_io.writeSingleByte(REGISTER_STATUS, status);
+	return status;
 }
 
-unsigned int SparkFun_AS7341X::read415nm()
-{	
-	// F1 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x00);
-	as7341_io.writeSingleByte(0x01, 0x01);
-	as7341_io.writeSingleByte(0x02, 0x00);
-	as7341_io.writeSingleByte(0x03, 0x00);
-	as7341_io.writeSingleByte(0x04, 0x00);
-	as7341_io.writeSingleByte(0x05, 0x00);
-	as7341_io.writeSingleByte(0x06, 0x00);
-	as7341_io.writeSingleByte(0x07, 0x00);
-	as7341_io.writeSingleByte(0x08, 0x00);
-	as7341_io.writeSingleByte(0x09, 0x00);
-	as7341_io.writeSingleByte(0x0a, 0x00);
-	as7341_io.writeSingleByte(0x0b, 0x00);
-	as7341_io.writeSingleByte(0x0c, 0x00);
-	as7341_io.writeSingleByte(0x0d, 0x00);
-	as7341_io.writeSingleByte(0x0e, 0x00);
-	as7341_io.writeSingleByte(0x0f, 0x00);
-	as7341_io.writeSingleByte(0x10, 0x01);
-	as7341_io.writeSingleByte(0x11, 0x00);
-	as7341_io.writeSingleByte(0x12, 0x00);
-	as7341_io.writeSingleByte(0x13, 0x00);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-	
-	return (unsigned int)readSingleChannelValue();
+bool SparkFun_AS7341X::isSmuxDone()
+{
+	// SMUXEN clears itself once the SMUX command has finished. Must bypass the shadow copy.
+	return ((as7341_io.fetchSingleByte(REGISTER_ENABLE) & (1 << 4)) == 0);
 }
 
-unsigned int SparkFun_AS7341X::read445nm()
+bool SparkFun_AS7341X::waitForSmux()
 {
-	// F2 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x01);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x10);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x0);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-		
-	return (unsigned int)readSingleChannelValue();
+	measurementStepStart = millis();
+	while (!isSmuxDone())
+	{
+		if (measurementStepTimedOut())
+			return false;
+	}
+	return true;
 }
 
-unsigned int SparkFun_AS7341X::read480nm()
+unsigned long SparkFun_AS7341X::getIntegrationMicros()
 {
-	// F3 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x10);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x0);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x0);
-	as7341_io.writeSingleByte(0x0f, 0x10);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-		
-	return (unsigned int)readSingleChannelValue();
+	// tint = (ATIME + 1) x (ASTEP + 1) x 2.78 us. Both come from the register shadow, no bus traffic.
+	return (unsigned long)((getATIME() + 1) * (uint32_t(getASTEP()) + 1) * 2.78f);
 }
 
-unsigned int SparkFun_AS7341X::read515nm()
+bool SparkFun_AS7341X::waitForSpectralData()
 {
-	// F4 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x10);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x01);
-	as7341_io.writeSingleByte(0x0e, 0x0);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-		
-	return (unsigned int)readSingleChannelValue();
+	integrationStart = micros();
+	measurementStepStart = millis();
+	
+	// AVALID can't be set before the integration time has elapsed
+	unsigned long integrationMicros = getIntegrationMicros();
+	delay(integrationMicros / 1000);
+	delayMicroseconds(integrationMicros % 1000);
+	
+	while (!as7341_io.isBitSet(REGISTER_STATUS_2, 6))
+	{
+		if (measurementStepTimedOut())
+			return false;
+		delayMicroseconds(STATUS_POLL_INTERVAL_US);
+	}
+	return true;
 }
 
-unsigned int SparkFun_AS7341X::read555nm()
+bool SparkFun_AS7341X::measurementStepTimedOut()
 {
-	// F5 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x0);
-	as7341_io.writeSingleByte(0x06, 0x10);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x10);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x0);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-		
-	return (unsigned int)readSingleChannelValue();
+	// Integrations can last up to 46.6 s, longer than the timeout itself
+	if (millis() - measurementStepStart <= MEASUREMENT_TIMEOUT_MS + getIntegrationMicros() / 1000)
+		return false;
+	
+	lastError = ERROR_AS7341X_MEASUREMENT_TIMEOUT;
+	measurementState = AS7341X_MEASUREMENT_STATE::ERROR;
+	return true;
 }
 
-unsigned int SparkFun_AS7341X::read590nm()
+byte SparkFun_AS7341X::readAdcData(uint16_t* destination)
 {
-	// F6 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
+	byte buffer[13];
+	
+	// Reading ASTATUS latches all 12 data bytes, so a single burst from 0x94 to 0xA0 is always concurrent
+	as7341_io.readMultipleBytes(REGISTER_ASTATUS, buffer, 13);
+	
+	for (int i = 0; i < 6; i++)
+		destination[i] = buffer[2*i + 2] << 8 | buffer[2*i + 1];
+	
+	// ADC5 belongs to flicker detection, there is no spectral data on it
+	if (flickerDetectionEnabled)
+		destination[5] = 0;
+	
+	lastAStatus = buffer[0];
+	lastReadMicros = micros();
+	return lastAStatus;
+}
+
+void SparkFun_AS7341X::configureWaitTime(unsigned long milliseconds)
+{
+	// One wait cycle is 2.78 ms, WLONG multiplies it by 16
+	unsigned long cycles = (milliseconds * 100 + 139) / 278;
+	bool waitLong = false;
+	if (cycles > 256)
+	{
+		waitLong = true;
+		cycles = (cycles + 8) / 16;
+	}
+	if (cycles < 1)
+		cycles = 1;
+	if (cycles > 256)
+		cycles = 256;
+	
+	as7341_io.writeSingleByte(REGISTER_WTIME, byte(cycles - 1));
+	if (waitLong)
+		as7341_io.setRegisterBit(REGISTER_CFG_0, 2);
+	else
+		as7341_io.clearRegisterBit(REGISTER_CFG_0, 2);
+}
+
+void SparkFun_AS7341X::setMuxLo()
+{
+	applySmuxTable(smuxLowChannels);
+}
+
+void SparkFun_AS7341X::setMuxHi()
+{
+	applySmuxTable(smuxHighChannels);
+}
+
+void SparkFun_AS7341X::applyMuxConfig(AS7341X_MUX_CONFIG muxConfig)
+{
+	if (muxConfig == AS7341X_MUX_CONFIG::F5_F8_CLEAR_NIR)
+		setMuxHi();
+	else
+		setMuxLo();
+}
+
+void SparkFun_AS7341X::applySmuxTable(const byte* smuxTable, byte enableValue)
+{
+	// Copy the table out of flash
+	byte smuxConfiguration[SMUX_TABLE_LENGTH];
+	memcpy_P(smuxConfiguration, smuxTable, SMUX_TABLE_LENGTH);
+	applySmuxImage(smuxConfiguration, enableValue);
+}
+
+void SparkFun_AS7341X::applySmuxImage(const byte* smuxImage, byte enableValue)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::SMUX);
+	
+	// Background flicker detection owns ADC5: disconnect whatever else was routed there, connect the flicker photodiode and keep FDEN set
+	byte flickerImage[SMUX_TABLE_LENGTH];
+	byte keepEnabled = 0;
+	if (flickerDetectionEnabled)
+	{
+		for (byte i = 0; i < SMUX_TABLE_LENGTH; i++)
+		{
+			byte value = smuxImage[i];
+			if ((value & 0x0f) == AS7341X_ADC_COUNT)
+				value &= 0xf0;
+			if ((value >> 4) == AS7341X_ADC_COUNT)
+				value &= 0x0f;
+			flickerImage[i] = value | pgm_read_byte(&smuxFlicker[i]);
+		}
+		smuxImage = flickerImage;
+		keepEnabled = 1 << 6;
+	}
+	
+	// According to AMS application note V1.1
+	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01 | keepEnabled);
 	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
+	// Enable the system interrupt, leaving spectral and FIFO interrupt enables untouched
+	as7341_io.setRegisterBit(REGISTER_INTENAB, 0);
 	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x01);
-	as7341_io.writeSingleByte(0x05, 0x0);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x10);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
+	
+	// Push the image to SMUX RAM (0x00 to 0x13) in one auto-increment burst
+	as7341_io.writeMultipleBytes(0x00, smuxImage, SMUX_TABLE_LENGTH);
+	
+	// Start the SMUX command
+	as7341_io.writeSingleByte(REGISTER_ENABLE, enableValue | keepEnabled);
+}
+
+void SparkFun_AS7341X::buildSmuxImage(const byte* channels, byte count, byte* smuxImage)
+{
+	memset(smuxImage, 0, SMUX_TABLE_LENGTH);
+	
+	for (byte adc = 0; adc < count && adc < AS7341X_ADC_COUNT; adc++)
+	{
+		for (byte i = 0; i < 2; i++)
+		{
+			byte pixel = pgm_read_byte(&smuxPixelMap[channels[adc]][i]);
+			if (pixel == 0xff)
+				continue;
+			
+			// Each nibble holds the ADC a photodiode is connected to, 1 based (0 = disconnected)
+			if (pixel & 0x01)
+				smuxImage[pixel >> 1] |= (adc + 1) << 4;
+			else
+				smuxImage[pixel >> 1] |= (adc + 1);
+		}
+	}
+}
+
+bool SparkFun_AS7341X::startFifoStreaming(byte adcMask, AS7341X_MUX_CONFIG muxConfig)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::FIFO);
+	
+	lastError = ERROR_NONE;
+	
+	adcMask &= 0x3f;
+	fifoChannelCount = 0;
+	for (byte i = 0; i < 6; i++)
+		if (adcMask & (1 << i))
+			fifoChannelCount++;
+	
+	applyMuxConfig(muxConfig);
+	if (!waitForSmux())
+		return false;
+	
+	// FIFO_WRITE_CH0_DATA is bit 1, ASTATUS (bit 0) is left out so every entry is two bytes
+	as7341_io.writeSingleByte(REGISTER_FIFO_MAP, adcMask << 1);
+	clearFifo();
+	
+	// Leave SP_EN set so the spectral engine free-runs and fills the FIFO
+	as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
+	return true;
+}
+
+void SparkFun_AS7341X::stopFifoStreaming()
+{
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 1);
+	as7341_io.writeSingleByte(REGISTER_FIFO_MAP, 0);
+	fifoChannelCount = 0;
+}
+
+uint16_t SparkFun_AS7341X::drainFifo(SparkFun_AS7341X_FifoBuffer& buffer)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::FIFO);
+	
+	byte level = as7341_io.readSingleByte(REGISTER_FIFO_LVL);
+	if (level == 0)
+		return 0;
+	
+	// A full FIFO may have dropped data. FIFO_OV clears on the next FIFO read, so check it first.
+	if (level >= FIFO_DEPTH && as7341_io.isBitSet(REGISTER_STATUS_6, 7))
+		buffer.setOverflow();
+	
+	// Only fetch what fits, the rest stays queued on the sensor
+	uint16_t space = buffer.freeSpace();
+	if (space < level)
+		level = space;
+	
+	uint16_t entries[FIFO_BURST_ENTRIES];
+	uint16_t drained = 0;
+	while (drained < level)
+	{
+		byte count = level - drained;
+		if (count > FIFO_BURST_ENTRIES)
+			count = FIFO_BURST_ENTRIES;
 		
+		readFifoEntries(entries, count);
+		for (byte i = 0; i < count; i++)
+			buffer.push(entries[i]);
+		
+		drained += count;
+	}
+	
+	return drained;
+}
+
+void SparkFun_AS7341X::readFifoEntries(uint16_t* destination, uint16_t count)
+{
+	byte data[2 * FIFO_BURST_ENTRIES];
+	while (count > 0)
+	{
+		byte entries = (count > FIFO_BURST_ENTRIES) ? FIFO_BURST_ENTRIES : count;
+		
+		// The register pointer wraps from FDATA_H back to FDATA_L, so one burst returns consecutive entries
+		as7341_io.readMultipleBytes(REGISTER_FDATA_L, data, 2 * entries);
+		for (byte i = 0; i < entries; i++)
+			*destination++ = data[2*i + 1] << 8 | data[2*i];
+		
+		count -= entries;
+	}
+}
+
+void SparkFun_AS7341X::clearFifo()
+{
+	as7341_io.writeSingleByte(REGISTER_CONTROL, 0x02);
+}
+
+byte SparkFun_AS7341X::getFifoChannelCount()
+{
+	return fifoChannelCount;
+}
+
+bool SparkFun_AS7341X::startContinuousMeasurement(unsigned long sampleIntervalMs, AS7341X_MUX_CONFIG muxConfig)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::CONTINUOUS);
+	
+	lastError = ERROR_NONE;
+	sampleSequence = 0;
+	
+	// WTIME sets the spectral cycle period. The engine ignores a period shorter than the integration time and
+	// would run at its own pace instead, so refuse it before touching the sensor.
+	if (sampleIntervalMs * 1000 < getIntegrationMicros())
+	{
+		lastError = ERROR_AS7341X_INVALID_WAIT_TIME;
+		return false;
+	}
+	
+	applyMuxConfig(muxConfig);
+	if (!waitForSmux())
+		return false;
+	
+	configureWaitTime(sampleIntervalMs);
+	
+	// Set WEN and SP_EN together and leave them on. Autozero and start-up are only paid once.
+	byte enable = as7341_io.readSingleByte(REGISTER_ENABLE);
+	as7341_io.writeSingleByte(REGISTER_ENABLE, enable | (1 << 3) | (1 << 1));
+	return true;
+}
+
+void SparkFun_AS7341X::stopContinuousMeasurement()
+{
+	byte enable = as7341_io.readSingleByte(REGISTER_ENABLE);
+	as7341_io.writeSingleByte(REGISTER_ENABLE, enable & ~((1 << 3) | (1 << 1)));
+}
+
+bool SparkFun_AS7341X::updateContinuousMeasurement()
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::CONTINUOUS);
+	
+	if (interruptDriven)
+	{
+		// Nothing to do until INT reports a completed spectral cycle
+		if ((takeInterruptStatus() & 0x08) == 0)
+			return false;
+	}
+	else if (!as7341_io.isBitSet(REGISTER_STATUS_2, 6))
+		return false;
+	
+	// Continuous mode only uses the first six entries of measurementData
+	passAStatus[0] = readAdcData(measurementData);
+	sampleTimestamp = millis();
+	sampleSequence++;
+	if (sampleSequence == 0)
+		sampleSequence = 1;
+	return true;
+}
+
+uint32_t SparkFun_AS7341X::getLatestSample(unsigned int* channelData)
+{
+	if (sampleSequence != 0)
+	{
+		for (int i = 0; i < 6; i++)
+			channelData[i] = measurementData[i];
+	}
+	return sampleSequence;
+}
+
+uint32_t SparkFun_AS7341X::getLatestSample(AS7341X_SAMPLE& sample)
+{
+	if (sampleSequence != 0)
+		fillSample(sample, true);
+	return sampleSequence;
+}
+
+uint32_t SparkFun_AS7341X::getSampleSequence()
+{
+	return sampleSequence;
+}
+
+unsigned long SparkFun_AS7341X::getSampleTimestamp()
+{
+	return sampleTimestamp;
+}
+
+void SparkFun_AS7341X::enableSleepAfterInterrupt()
+{
+	// SAI only acts on asserted interrupts, so every spectral cycle has to raise AINT
+	setAPERS(0);
+	as7341_io.setRegisterBit(REGISTER_INTENAB, 3);
+	as7341_io.setRegisterBit(REGISTER_CFG_3, 4);
+	sleepAfterInterrupt = true;
+	
+	// A stale AINT from earlier measurements would put the sensor to sleep right away
+	wakeFromSleepAfterInterrupt();
+}
+
+void SparkFun_AS7341X::disableSleepAfterInterrupt()
+{
+	as7341_io.clearRegisterBit(REGISTER_CFG_3, 4);
+	
+	// Interrupt driven measurements still need AINT
+	if (!interruptDriven)
+		as7341_io.clearRegisterBit(REGISTER_INTENAB, 3);
+	
+	sleepAfterInterrupt = false;
+	wakeFromSleepAfterInterrupt();
+}
+
+bool SparkFun_AS7341X::isSleepAfterInterruptEnabled()
+{
+	return sleepAfterInterrupt;
+}
+
+void SparkFun_AS7341X::wakeFromSleepAfterInterrupt()
+{
+	// AINT and SINT
+	as7341_io.writeSingleByte(REGISTER_STATUS, 0x09);
+}
+
+void SparkFun_AS7341X::enableLowPowerIdle()
+{
+	as7341_io.setRegisterBit(REGISTER_CFG_0, 5);
+}
+
+void SparkFun_AS7341X::disableLowPowerIdle()
+{
+	as7341_io.clearRegisterBit(REGISTER_CFG_0, 5);
+}
+
+float SparkFun_AS7341X::getWaitTime()
+{
+	float period = (as7341_io.readSingleByte(REGISTER_WTIME) + 1) * 2.78f;
+	if (as7341_io.isBitSet(REGISTER_CFG_0, 2))
+		period *= 16;
+	return period;
+}
+
+bool SparkFun_AS7341X::readAllChannelsBasicCounts(float* channelDataBasicCounts)
+{
+	lastError = ERROR_NONE;
+	
+	unsigned int rawChannelData[12];
+	bool result = readAllChannels(rawChannelData);
+	
+	if (result == false)
+		return false;
+	
+	// Each pass is normalized by the gain it was actually measured with, which differs under AGC
+	for (int pass = 0; pass < 2; pass++)
+	{
+		float scale = getBasicCountScale(passAStatus[pass] & 0x0f);
+		for (int i = 6 * pass; i < 6 * pass + 6; i++)
+			channelDataBasicCounts[i] = float(rawChannelData[i]) * scale;
+	}
+	
+	return true;
+}
+
+void SparkFun_AS7341X::enablePinInterupt()
+{
+	as7341_io.setRegisterBit(REGISTER_INTENAB, 0);
+}
+
+void SparkFun_AS7341X::disablePinInterrupt()
+{
+	as7341_io.clearRegisterBit(REGISTER_INTENAB, 0);
+}
+
+void SparkFun_AS7341X::clearPinInterrupt()
+{
+	as7341_io.writeSingleByte(REGISTER_STATUS, 0xff);
+}
+
+byte SparkFun_AS7341X::readRegister(byte reg)
+{
+	return as7341_io.readSingleByte(reg);
+}
+
+void SparkFun_AS7341X::writeRegister(byte reg, byte value)
+{
+	invalidateBasicCountScale();
+	as7341_io.writeSingleByte(reg, value);
+}
+
+void SparkFun_AS7341X::resyncRegisterCache()
+{
+	invalidateBasicCountScale();
+	as7341_io.resyncShadowRegisters();
+}
+
+#if AS7341X_IO_STATS
+void SparkFun_AS7341X::getIOStats(SparkFun_AS7341X_IOStats& stats)
+{
+	as7341_io.getStats(stats);
+}
+
+void SparkFun_AS7341X::getIOStats(AS7341X_IO_SITE site, SparkFun_AS7341X_IOStats& stats)
+{
+	as7341_io.getStats(site, stats);
+}
+
+void SparkFun_AS7341X::resetIOStats()
+{
+	as7341_io.resetStats();
+}
+#endif
+
+void SparkFun_AS7341X::setGpioPinInput()
+{
+	// Disable GPIO as output driver
+	as7341_io.setRegisterBit(REGISTER_GPIO_2, 1);
+	// Enable GPIO as input
+	as7341_io.setRegisterBit(REGISTER_GPIO_2, 2);
+}
+
+void SparkFun_AS7341X::setGpioPinOutput()
+{
+	// Disable GPIO input
+	as7341_io.clearRegisterBit(REGISTER_GPIO_2, 2);
+}
+
+bool SparkFun_AS7341X::digitalRead()
+{
+	return as7341_io.isBitSet(REGISTER_GPIO_2, 0);
+}
+
+void SparkFun_AS7341X::invertGpioOutput(bool isInverted)
+{
+	if (isInverted)
+		as7341_io.setRegisterBit(REGISTER_GPIO_2, 3);
+	else
+		as7341_io.clearRegisterBit(REGISTER_GPIO_2, 3);
+}
+
+void SparkFun_AS7341X::digitalWrite(byte value)
+{
+	// If value is 0, let go the driver
+	if(value == 0)
+		as7341_io.clearRegisterBit(REGISTER_GPIO_2, 1);
+	else
+		as7341_io.setRegisterBit(REGISTER_GPIO_2, 1);
+}
+
+uint16_t SparkFun_AS7341X::readSingleChannelValue()
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::READ_SINGLE_CHANNEL);
+	
+	lastError = ERROR_NONE;
+	
+	// Wait for the SMUX command to finish before starting the measurement
+	if (!waitForSmux())
+		return 0;
+	
+	as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
+	if (!waitForSpectralData())
+		return 0;
+	
+	// Start at ASTATUS so the data is latched and the gain used is known
+	byte buffer[3] = { 0 };
+	
+	as7341_io.readMultipleBytes(REGISTER_ASTATUS, buffer, 3);
+	lastAStatus = buffer[0];
+	passAStatus[0] = lastAStatus;
+	uint16_t result = buffer[2] << 8;
+	result += buffer[1];
+	
+	return result;
+}
+
+unsigned int SparkFun_AS7341X::read415nm()
+{
+	// F1 -> ADC0
+	applySmuxTable(smux415nm);
+	
+	return (unsigned int)readSingleChannelValue();
+}
+
+unsigned int SparkFun_AS7341X::read445nm()
+{
+	// F2 -> ADC0
+	applySmuxTable(smux445nm);
+	
+	return (unsigned int)readSingleChannelValue();
+}
+
+unsigned int SparkFun_AS7341X::read480nm()
+{
+	// F3 -> ADC0
+	applySmuxTable(smux480nm);
+	
+	return (unsigned int)readSingleChannelValue();
+}
+
+unsigned int SparkFun_AS7341X::read515nm()
+{
+	// F4 -> ADC0
+	applySmuxTable(smux515nm);
+	
+	return (unsigned int)readSingleChannelValue();
+}
+
+unsigned int SparkFun_AS7341X::read555nm()
+{
+	// F5 -> ADC0
+	applySmuxTable(smux555nm);
+	
+	return (unsigned int)readSingleChannelValue();
+}
+
+unsigned int SparkFun_AS7341X::read590nm()
+{
+	// F6 -> ADC0
+	applySmuxTable(smux590nm);
+	
 	return (unsigned int)readSingleChannelValue();
 }
 
 unsigned int SparkFun_AS7341X::read630nm()
 {
 	// F7 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x0);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x01);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x01);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x0);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-		
+	applySmuxTable(smux630nm);
+	
+	return (unsigned int)readSingleChannelValue();
+}
+
+unsigned int SparkFun_AS7341X::read680nm()
+{
+	// F8 -> ADC0
+	applySmuxTable(smux680nm);
+	
+	return (unsigned int)readSingleChannelValue();
+}
+
+unsigned int SparkFun_AS7341X::readClear()
+{
+	//	Clear -> ADC0
+	applySmuxTable(smuxClear);
+	
 	return (unsigned int)readSingleChannelValue();
 }
 
-unsigned int SparkFun_AS7341X::read680nm()
+bool SparkFun_AS7341X::integrateAdcs(uint16_t* adcData)
+{
+	if (!waitForSmux())
+		return false;
+	
+	as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
+	if (!waitForSpectralData())
+		return false;
+	
+	readAdcData(adcData);
+	return true;
+}
+
+bool SparkFun_AS7341X::readChannelPass(const byte* channels, byte count, unsigned int* channelData)
+{
+	byte smuxImage[SMUX_TABLE_LENGTH];
+	buildSmuxImage(channels, count, smuxImage);
+	applySmuxImage(smuxImage);
+	
+	uint16_t adcData[AS7341X_ADC_COUNT];
+	if (!integrateAdcs(adcData))
+		return false;
+	
+	for (byte i = 0; i < count; i++)
+		channelData[channels[i]] = adcData[i];
+	
+	return true;
+}
+
+bool SparkFun_AS7341X::readSmuxTable(const byte* smuxTable, unsigned int* adcData)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::READ_CHANNELS);
+	
+	lastError = ERROR_NONE;
+	
+	applySmuxTable(smuxTable);
+	
+	uint16_t data[AS7341X_ADC_COUNT];
+	if (!integrateAdcs(data))
+		return false;
+	
+	passAStatus[0] = lastAStatus;
+	for (byte i = 0; i < AS7341X_ADC_COUNT; i++)
+		adcData[i] = data[i];
+	
+	return true;
+}
+
+bool SparkFun_AS7341X::readChannels(uint16_t channelMask, unsigned int* channelData)
 {
-	// F8 -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x10);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x0);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x01);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::READ_CHANNELS);
+	
+	lastError = ERROR_NONE;
+	
+	// Fill the six ADCs (five while flicker detection holds ADC5) before starting a new integration
+	byte adcCount = flickerDetectionEnabled ? AS7341X_ADC_COUNT - 1 : AS7341X_ADC_COUNT;
+	byte channels[AS7341X_ADC_COUNT];
+	byte count = 0;
+	byte pass = 0;
+	for (byte channel = 0; channel < AS7341X_CHANNEL_COUNT; channel++)
+	{
+		if ((channelMask & (1 << channel)) == 0)
+			continue;
 		
-	return (unsigned int)readSingleChannelValue();
+		channels[count++] = channel;
+		if (count == adcCount)
+		{
+			if (!readChannelPass(channels, count, channelData))
+				return false;
+			passAStatus[pass++] = lastAStatus;
+			count = 0;
+		}
+	}
+	
+	if (count > 0)
+	{
+		if (!readChannelPass(channels, count, channelData))
+			return false;
+		passAStatus[pass] = lastAStatus;
+	}
+	
+	return true;
 }
 
-unsigned int SparkFun_AS7341X::readClear()
+bool SparkFun_AS7341X::readAllChannelsBasicCountsFixed(uint32_t* channelDataBasicCounts)
 {
-	//	Clear -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x0);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x10);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x0);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x10);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x0);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-		
-	return (unsigned int)readSingleChannelValue();
+	lastError = ERROR_NONE;
+	
+	unsigned int rawChannelData[12];
+	if (!readAllChannels(rawChannelData))
+		return false;
+	
+	for (int i = 0; i < 12; i++)
+		channelDataBasicCounts[i] = convertBasicCountFixed(rawChannelData[i], passAStatus[i / 6] & 0x0f);
+	
+	return true;
 }
 
 unsigned int SparkFun_AS7341X::readNIR()
 {
 	//	NIR -> ADC0
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x0, 0x0);
-	as7341_io.writeSingleByte(0x01, 0x0);
-	as7341_io.writeSingleByte(0x02, 0x0);
-	as7341_io.writeSingleByte(0x03, 0x0);
-	as7341_io.writeSingleByte(0x04, 0x0);
-	as7341_io.writeSingleByte(0x05, 0x0);
-	as7341_io.writeSingleByte(0x06, 0x0);
-	as7341_io.writeSingleByte(0x07, 0x0);
-	as7341_io.writeSingleByte(0x08, 0x0);
-	as7341_io.writeSingleByte(0x09, 0x0);
-	as7341_io.writeSingleByte(0x0a, 0x0);
-	as7341_io.writeSingleByte(0x0b, 0x0);
-	as7341_io.writeSingleByte(0x0c, 0x0);
-	as7341_io.writeSingleByte(0x0d, 0x0);
-	as7341_io.writeSingleByte(0x0e, 0x0);
-	as7341_io.writeSingleByte(0x0f, 0x0);
-	as7341_io.writeSingleByte(0x10, 0x0);
-	as7341_io.writeSingleByte(0x11, 0x0);
-	as7341_io.writeSingleByte(0x12, 0x0);
-	as7341_io.writeSingleByte(0x13, 0x01);
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x11);
-		
+	applySmuxTable(smuxNIR);
+	
 	return (unsigned int)readSingleChannelValue();
 }
 
 float SparkFun_AS7341X::readSingleBasicCountChannelValue(uint16_t raw)
 {
-	uint16_t aTime = (uint16_t) getATIME();
-	uint16_t aStep = getASTEP();
-	uint16_t tint = (aTime + 1) * (aStep * 1) * 2.78 / 1000;
-		
-	byte value = as7341_io.readSingleByte(REGISTER_CFG_1);
-	value &= 0x1f;
+	// Under AGC CFG_1 already holds the gain for the next cycle, the one used for raw is in ASTATUS
+	byte value;
+	if (agcEnabled)
+		value = lastAStatus & 0x0f;
+	else
+		value = as7341_io.readSingleByte(REGISTER_CFG_1) & 0x1f;
+	return float(raw) * getBasicCountScale(value);
+}
 
-	float gain;
-	if (value == 0)
-	{
-		gain = 0.5f;
-	}
+uint32_t SparkFun_AS7341X::readSingleBasicCountChannelValueFixed(uint16_t raw)
+{
+	byte value;
+	if (agcEnabled)
+		value = lastAStatus & 0x0f;
 	else
-	{
-		gain = pow(2, (value - 1));
-	}
+		value = as7341_io.readSingleByte(REGISTER_CFG_1) & 0x1f;
 	
-	return (float(raw) / (gain * tint));
+	return convertBasicCountFixed(raw, value);
 }
 
 float SparkFun_AS7341X::readBasicCount415nm()
@@ -946,6 +1573,56 @@ float SparkFun_AS7341X::readBasicCountNIR()
 	return readSingleBasicCountChannelValue(readNIR());
 }
 
+uint32_t SparkFun_AS7341X::readBasicCountFixed415nm()
+{
+	return readSingleBasicCountChannelValueFixed(read415nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixed445nm()
+{
+	return readSingleBasicCountChannelValueFixed(read445nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixed480nm()
+{
+	return readSingleBasicCountChannelValueFixed(read480nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixed515nm()
+{
+	return readSingleBasicCountChannelValueFixed(read515nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixed555nm()
+{
+	return readSingleBasicCountChannelValueFixed(read555nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixed590nm()
+{
+	return readSingleBasicCountChannelValueFixed(read590nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixed630nm()
+{
+	return readSingleBasicCountChannelValueFixed(read630nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixed680nm()
+{
+	return readSingleBasicCountChannelValueFixed(read680nm());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixedClear()
+{
+	return readSingleBasicCountChannelValueFixed(readClear());
+}
+
+uint32_t SparkFun_AS7341X::readBasicCountFixedNIR()
+{
+	return readSingleBasicCountChannelValueFixed(readNIR());
+}
+
 void SparkFun_AS7341X::setLowThreshold(unsigned int threshold)
 {
 	byte low = threshold & 0xff;
@@ -985,7 +1662,7 @@ void SparkFun_AS7341X::setAPERS(byte value)
 	
 	// Get current APERS value and change bits 3..0 only
 	byte currentAPERS = getAPERS();
-	currentAPERS &= 0x0f;
+	currentAPERS &= 0xf0;
 	currentAPERS |= value;
 	// Write value back
 	as7341_io.writeSingleByte(REGISTER_PERS, currentAPERS);
@@ -998,17 +1675,17 @@ byte SparkFun_AS7341X::getAPERS()
 
 void SparkFun_AS7341X::enableMeasurements()
 {
-	as7341_io.setRegisterBit(REGISTER_STATUS, 1);
+	as7341_io.setRegisterBit(REGISTER_ENABLE, 1);
 }
 
 void SparkFun_AS7341X::disableMeasurements()
 {
-	as7341_io.clearRegisterBit(REGISTER_STATUS, 1);
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 1);
 }
 
 bool SparkFun_AS7341X::isMeasurementEnabled()
 {
-	return as7341_io.isBitSet(REGISTER_STATUS, 1);
+	return as7341_io.isBitSet(REGISTER_ENABLE, 1);
 }
 
 void SparkFun_AS7341X::clearThresholdInterrupts()
@@ -1016,9 +1693,23 @@ void SparkFun_AS7341X::clearThresholdInterrupts()
 	as7341_io.writeSingleByte(REGISTER_STATUS, 0xff);
 }
 
+void SparkFun_AS7341X::setThresholdChannel(byte adc)
+{
+	if (adc > 4)
+		adc = 4;
+	
+	thresholdChannel = adc;
+	as7341_io.writeSingleByte(REGISTER_CFG_12, adc);
+}
+
+byte SparkFun_AS7341X::getThresholdChannel()
+{
+	return thresholdChannel;
+}
+
 void SparkFun_AS7341X::enableThresholdInterrupt()
 {
-	as7341_io.writeSingleByte(REGISTER_CFG_12, 0);
+	as7341_io.writeSingleByte(REGISTER_CFG_12, thresholdChannel);
 	delay(10);
 	as7341_io.setRegisterBit(REGISTER_INTENAB, 3);
 }
@@ -1056,9 +1747,181 @@ bool SparkFun_AS7341X::highThresholdInterruptSet()
 	}
 }
 
+// Position of an optical channel in the 12 entry readAllChannels layout, for the F1-F4 (pass 0) or F5-F8 (pass 1) half
+static byte sampleIndex(byte channel, byte pass)
+{
+	if (channel == 8)
+		return 6 * pass + 4;
+	if (channel == 9)
+		return 6 * pass + 5;
+	return channel + 2 * pass;
+}
+
+bool SparkFun_AS7341X::startThresholdMonitoring(byte channel, unsigned int lowThreshold, unsigned int highThreshold, byte persistence,
+	unsigned long intervalMs)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::THRESHOLD);
+	
+	lastError = ERROR_NONE;
+	if (channel >= AS7341X_CHANNEL_COUNT)
+		return false;
+	
+	// Monitor the half of the spectrum the channel belongs to. Clear and NIR are in both, F1-F4 is used.
+	thresholdMonitorPass = (channel >= 4 && channel < 8) ? 1 : 0;
+	for (byte i = 0; i < 4; i++)
+		thresholdMonitorChannels[i] = 4 * thresholdMonitorPass + i;
+	thresholdMonitorChannels[4] = 8;
+	thresholdMonitorChannels[5] = 9;
+	
+	// SP_TH_CH only reaches ADC0 to ADC4, so NIR swaps places with Clear
+	byte adc = (channel < 8) ? channel - 4 * thresholdMonitorPass : channel - 4;
+	if (adc == 5)
+	{
+		thresholdMonitorChannels[4] = 9;
+		thresholdMonitorChannels[5] = 8;
+		adc = 4;
+	}
+	setThresholdChannel(adc);
+	
+	setLowThreshold(lowThreshold);
+	setHighThreshold(highThreshold);
+	
+	// APERS 0 would raise AINT on every cycle
+	if (persistence < 1)
+		persistence = 1;
+	setAPERS(persistence);
+	
+	configureWaitTime(intervalMs);
+	as7341_io.setRegisterBit(REGISTER_INTENAB, 3);
+	
+	thresholdEvent = AS7341X_THRESHOLD_EVENT::NONE;
+	thresholdEventCount = 0;
+	thresholdMonitoring = true;
+	
+	if (!resumeThresholdMonitoring())
+	{
+		stopThresholdMonitoring();
+		return false;
+	}
+	return true;
+}
+
+bool SparkFun_AS7341X::resumeThresholdMonitoring()
+{
+	byte smuxImage[SMUX_TABLE_LENGTH];
+	buildSmuxImage(thresholdMonitorChannels, AS7341X_ADC_COUNT, smuxImage);
+	applySmuxImage(smuxImage);
+	if (!waitForSmux())
+		return false;
+	
+	// Drop SINT from the SMUX command and anything left from the event
+	as7341_io.writeSingleByte(REGISTER_STATUS, 0xff);
+	interruptPending = false;
+	
+	// Sleep after interrupt keeps the cycle that fired in the data registers until the event is handled. Only set once
+	// SMUX is done: SAI acts on any interrupt, SINT included.
+	as7341_io.setRegisterBit(REGISTER_CFG_3, 4);
+	
+	// Set WEN and SP_EN together, the sensor free-runs from here on
+	byte enable = as7341_io.readSingleByte(REGISTER_ENABLE);
+	as7341_io.writeSingleByte(REGISTER_ENABLE, enable | (1 << 3) | (1 << 1));
+	return true;
+}
+
+void SparkFun_AS7341X::stopThresholdMonitoring()
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::THRESHOLD);
+	
+	byte enable = as7341_io.readSingleByte(REGISTER_ENABLE);
+	as7341_io.writeSingleByte(REGISTER_ENABLE, enable & ~((1 << 3) | (1 << 1)));
+	
+	// Leave SAI and the spectral interrupt to whoever else still needs them
+	if (!sleepAfterInterrupt)
+		as7341_io.clearRegisterBit(REGISTER_CFG_3, 4);
+	if (!sleepAfterInterrupt && !interruptDriven)
+		as7341_io.clearRegisterBit(REGISTER_INTENAB, 3);
+	
+	as7341_io.writeSingleByte(REGISTER_STATUS, 0xff);
+	interruptPending = false;
+	thresholdMonitoring = false;
+}
+
+bool SparkFun_AS7341X::isThresholdMonitoringEnabled()
+{
+	return thresholdMonitoring;
+}
+
+bool SparkFun_AS7341X::updateThresholdMonitoring()
+{
+	// No INT event, no bus traffic
+	if (!thresholdMonitoring || !interruptPending)
+		return false;
+	interruptPending = false;
+	
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::THRESHOLD);
+	
+	lastError = ERROR_NONE;
+	
+	byte status = as7341_io.readSingleByte(REGISTER_STATUS);
+	if ((status & 0x08) == 0)
+	{
+		// Not ours, release the INT pin
+		if (status != 0)
+			as7341_io.writeSingleByte(REGISTER_STATUS, status);
+		return false;
+	}
+	
+	// The sensor is asleep after the interrupt, so the data registers still hold the cycle that fired
+	byte thresholdStatus = as7341_io.readSingleByte(REGISTER_STATUS_3);
+	uint16_t adcData[AS7341X_ADC_COUNT];
+	passAStatus[thresholdMonitorPass] = readAdcData(adcData);
+	thresholdEventMicros = lastReadMicros;
+	for (byte i = 0; i < AS7341X_ADC_COUNT; i++)
+		measurementData[sampleIndex(thresholdMonitorChannels[i], thresholdMonitorPass)] = adcData[i];
+	
+	if (thresholdStatus & (1 << 5))
+		thresholdEvent = AS7341X_THRESHOLD_EVENT::ABOVE;
+	else if (thresholdStatus & (1 << 4))
+		thresholdEvent = AS7341X_THRESHOLD_EVENT::BELOW;
+	else if (adcData[thresholdChannel] > getHighThreshold())
+		thresholdEvent = AS7341X_THRESHOLD_EVENT::ABOVE;
+	else
+		thresholdEvent = AS7341X_THRESHOLD_EVENT::BELOW;
+	thresholdEventCount++;
+	
+	// One integration of the other half completes the spectrum. Its SMUX command raises SINT, so SAI is off until
+	// monitoring resumes. Applying SMUX stops the free-running engine, and releasing AINT wakes the sensor from SAI sleep.
+	as7341_io.clearRegisterBit(REGISTER_CFG_3, 4);
+	as7341_io.writeSingleByte(REGISTER_STATUS, status);
+	byte otherPass = 1 - thresholdMonitorPass;
+	applyMuxConfig(otherPass ? AS7341X_MUX_CONFIG::F5_F8_CLEAR_NIR : AS7341X_MUX_CONFIG::F1_F4_CLEAR_NIR);
+	bool result = integrateAdcs(measurementData + 6 * otherPass);
+	passAStatus[otherPass] = lastAStatus;
+	
+	if (!resumeThresholdMonitoring())
+		return false;
+	return result;
+}
+
+AS7341X_THRESHOLD_EVENT SparkFun_AS7341X::getThresholdEvent(AS7341X_SAMPLE& sample)
+{
+	if (thresholdEvent != AS7341X_THRESHOLD_EVENT::NONE)
+	{
+		fillSample(sample, false);
+		sample.timestamp = thresholdEventMicros;
+	}
+	return thresholdEvent;
+}
+
+uint32_t SparkFun_AS7341X::getThresholdEventCount()
+{
+	return thresholdEventCount;
+}
 
 int SparkFun_AS7341X::getFlickerFrequency()
 {
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::FLICKER);
+	
 	lastError = ERROR_NONE;
 	
 	// Do not attempt to measure on a L chip - return -1 instead
@@ -1068,67 +1931,221 @@ int SparkFun_AS7341X::getFlickerFrequency()
 		return -1;
 	}
 	
+	// Background detection already has an answer, don't disturb it
+	if (flickerDetectionEnabled)
+	{
+		updateFlickerDetection();
+		return (flickerResult < 0) ? 0 : flickerResult;
+	}
+	
 	// Configure SMUX for flicker detection
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_9, 0x10);
-	as7341_io.writeSingleByte(REGISTER_INTENAB, 0x01);
-	as7341_io.writeSingleByte(REGISTER_CFG_6, 0x10);
-	as7341_io.writeSingleByte(0x00, 0x00);
-	as7341_io.writeSingleByte(0x01, 0x00);
-	as7341_io.writeSingleByte(0x02, 0x00);
-	as7341_io.writeSingleByte(0x03, 0x00);
-	as7341_io.writeSingleByte(0x04, 0x00);
-	as7341_io.writeSingleByte(0x05, 0x00);
-	as7341_io.writeSingleByte(0x06, 0x00);
-	as7341_io.writeSingleByte(0x07, 0x00);
-	as7341_io.writeSingleByte(0x08, 0x00);
-	as7341_io.writeSingleByte(0x09, 0x00);
-	as7341_io.writeSingleByte(0x0A, 0x00);
-	as7341_io.writeSingleByte(0x0B, 0x00);
-	as7341_io.writeSingleByte(0x0C, 0x00);
-	as7341_io.writeSingleByte(0x0D, 0x00);
-	as7341_io.writeSingleByte(0x0E, 0x00);
-	as7341_io.writeSingleByte(0x0F, 0x00);
-	as7341_io.writeSingleByte(0x10, 0x00);
-	as7341_io.writeSingleByte(0x11, 0x00);
-	as7341_io.writeSingleByte(0x12, 0x00);
-	as7341_io.writeSingleByte(0x13, 0x60); 
-	as7341_io.writeSingleByte(REGISTER_ENABLE, 0x13);
-	
-	// Set FD integration time to approx 2.84ms and gain to 32x (7:3 --> 6)
-	// FD time is 0x3ff (maximum allowable integration time)
+	applySmuxTable(smuxFlicker);
+	if (!waitForSmux())
+		return 0;
+	
+	// Same FD settings as background detection: about 2.84 ms at flickerGain (32x unless startFlickerDetection chose
+	// another), stale result cleared, FDEN set
+	configureFlickerDetection();
+	
+	// Wait for FD_MEASUREMENT_VALID. A result takes many FD integrations, so FD_STATUS is only read every
+	// FLICKER_POLL_INTERVAL_MS.
+	unsigned long start = millis();
+	byte flickerStatus;
+	do
+	{
+		delay(FLICKER_POLL_INTERVAL_MS);
+		flickerStatus = as7341_io.readSingleByte(REGISTER_FD_STATUS);
+		if ((flickerStatus & (1 << 5)) == 0 && millis() - start > MEASUREMENT_TIMEOUT_MS)
+		{
+			lastError = ERROR_AS7341X_MEASUREMENT_TIMEOUT;
+			break;
+		}
+	} while ((flickerStatus & (1 << 5)) == 0);
+	
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 6);
+	
+	return flickerFrequencyFromStatus(flickerStatus);
+}
+
+bool SparkFun_AS7341X::startFlickerDetection(AS7341X_GAIN gain)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::FLICKER);
+	
+	lastError = ERROR_NONE;
+	
+	if (device == AS7341X_DEVICE::AS7341L)
+	{
+		lastError = ERROR_AS7341X_INVALID_DEVICE;
+		return false;
+	}
+	
+	if (gain == AS7341X_GAIN::GAIN_INVALID)
+		gain = AS7341X_GAIN::GAIN_X32;
+	
+	flickerGain = gain;
+	flickerResult = -1;
+	flickerSaturated = false;
+	flickerSequence = 0;
+	
+	// From now on every SMUX configuration routes the flicker photodiode to ADC5
+	flickerDetectionEnabled = true;
+	applySmuxTable(smuxFlicker);
+	if (!waitForSmux())
+	{
+		stopFlickerDetection();
+		return false;
+	}
+	
+	configureFlickerDetection();
+	return true;
+}
+
+void SparkFun_AS7341X::stopFlickerDetection()
+{
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 6);
+	flickerDetectionEnabled = false;
+}
+
+bool SparkFun_AS7341X::isFlickerDetectionEnabled()
+{
+	return flickerDetectionEnabled;
+}
+
+void SparkFun_AS7341X::configureFlickerDetection()
+{
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 6);
+	
+	// Longest FD integration time (0x3ff steps, about 2.84 ms) with the selected gain in bits 7:3
 	as7341_io.writeSingleByte(REGISTER_FD_TIME_1, 0xff);
-	as7341_io.writeSingleByte(REGISTER_FD_TIME_2, 0x1b);
+	as7341_io.writeSingleByte(REGISTER_FD_TIME_2, (byte)flickerGain << 3 | 0x03);
 	
-	// Enable flicker detection
+	as7341_io.writeSingleByte(REGISTER_FD_STATUS, 0x3c);
 	as7341_io.setRegisterBit(REGISTER_ENABLE, 6);
+}
+
+bool SparkFun_AS7341X::updateFlickerDetection()
+{
+	if (!flickerDetectionEnabled)
+		return false;
+	
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::FLICKER);
 	
-	// Get resulting flicker status
 	byte flickerStatus = as7341_io.readSingleByte(REGISTER_FD_STATUS);
+	if ((flickerStatus & (1 << 5)) == 0)
+		return false;
+	
+	flickerResult = flickerFrequencyFromStatus(flickerStatus);
+	flickerSaturated = (flickerStatus & (1 << 4)) != 0;
+	flickerSequence++;
+	
+	// FD_MEASUREMENT_VALID, FD_SATURATION_DETECTED and both valid flags clear when written with ones
+	as7341_io.writeSingleByte(REGISTER_FD_STATUS, 0x3c);
+	return true;
+}
+
+int SparkFun_AS7341X::getFlickerResult()
+{
+	return flickerResult;
+}
+
+bool SparkFun_AS7341X::isFlickerSaturated()
+{
+	return flickerSaturated;
+}
+
+uint32_t SparkFun_AS7341X::getFlickerSequence()
+{
+	return flickerSequence;
+}
+
+bool SparkFun_AS7341X::captureFlickerWaveform(uint16_t* samples, uint16_t count, uint16_t sampleRate, AS7341X_GAIN gain)
+{
+	AS7341X_IO_SCOPE(as7341_io, AS7341X_IO_SITE::FLICKER);
+	
+	lastError = ERROR_NONE;
+	
+	if (device == AS7341X_DEVICE::AS7341L)
+	{
+		lastError = ERROR_AS7341X_INVALID_DEVICE;
+		return false;
+	}
+	
+	if (sampleRate == 0)
+		sampleRate = 1;
+	if (gain == AS7341X_GAIN::GAIN_INVALID)
+		gain = AS7341X_GAIN::GAIN_X32;
+	
+	// Each raw flicker sample integrates for FD_TIME + 1 steps of 2.78 us (11 bits)
+	uint32_t steps = (100000000UL + 139UL * sampleRate) / (278UL * sampleRate);
+	if (steps < 1)
+		steps = 1;
+	if (steps > 2048)
+		steps = 2048;
+	uint16_t fdTime = steps - 1;
+	flickerSampleRate = 100000000.0f / (278.0f * steps);
+	
+	// Route the flicker photodiode to ADC5, leaving the spectral engine off
+	applySmuxTable(smuxFlicker);
+	if (!waitForSmux())
+		return false;
+	
+	// Background detection keeps FDEN set through SMUX changes, stop the flicker engine while it is reconfigured
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 6);
+	
+	as7341_io.writeSingleByte(REGISTER_FD_TIME_1, fdTime & 0xff);
+	as7341_io.writeSingleByte(REGISTER_FD_TIME_2, (byte)gain << 3 | fdTime >> 8);
+	
+	// Only raw flicker data goes to the FIFO (FIFO_WRITE_FD)
+	as7341_io.writeSingleByte(REGISTER_FIFO_MAP, 0);
+	fifoChannelCount = 0;
+	as7341_io.setRegisterBit(REGISTER_FD_CFG0, 7);
+	clearFifo();
+	as7341_io.setRegisterBit(REGISTER_ENABLE, 6);
 	
-	if (as7341_io.isBitSet(REGISTER_FD_STATUS, 5))
+	// Allow for the capture itself on top of the usual timeout
+	unsigned long timeout = MEASUREMENT_TIMEOUT_MS + (uint32_t)count * 1000UL / sampleRate;
+	unsigned long start = millis();
+	uint16_t captured = 0;
+	while (captured < count)
 	{
-		// mask result
-		flickerStatus &= 0x0c;
-		// Shift right 2 bits
-		flickerStatus = flickerStatus >> 2;
+		byte level = as7341_io.readSingleByte(REGISTER_FIFO_LVL);
 		
-		switch (flickerStatus)
+		// A full FIFO may have dropped samples and the waveform would have a gap
+		if (level >= FIFO_DEPTH && as7341_io.isBitSet(REGISTER_STATUS_6, 7))
 		{
-		case 1:
-			return 100;
-			
-		case 2:
-			return 120;
-			
-		case 3:
-		default:
-			return 0;
+			lastError = ERROR_AS7341X_FIFO_OVERFLOW;
+			break;
 		}
+		
+		if (level == 0)
+		{
+			if (millis() - start > timeout)
+			{
+				lastError = ERROR_AS7341X_MEASUREMENT_TIMEOUT;
+				break;
+			}
+			continue;
+		}
+		
+		if (level > count - captured)
+			level = count - captured;
+		readFifoEntries(samples + captured, level);
+		captured += level;
 	}
-	else
-	{
-		return 0;
-	}
+	
+	// Stop flicker detection and hand the FIFO back to spectral data
+	as7341_io.clearRegisterBit(REGISTER_ENABLE, 6);
+	as7341_io.clearRegisterBit(REGISTER_FD_CFG0, 7);
+	clearFifo();
+	
+	// Resume background detection with its own settings
+	if (flickerDetectionEnabled)
+		configureFlickerDetection();
+	
+	return lastError == ERROR_NONE;
+}
 
+float SparkFun_AS7341X::getFlickerSampleRate()
+{
+	return flickerSampleRate;
 }
@@ -21,6 +21,14 @@
 
 #include "SparkFun_AS7341X_Constants.h"
 #include "SparkFun_AS7341X_IO.h"
+#include "SparkFun_AS7341X_Buffers.h"
+#include "SparkFun_AS7341X_Smux.h"
+#include "SparkFun_AS7341X_AutoExposure.h"
+#include "SparkFun_AS7341X_Manager.h"
+#include "SparkFun_AS7341X_Flicker.h"
+#include "SparkFun_AS7341X_Color.h"
+#include "SparkFun_AS7341X_Frame.h"
+#include "SparkFun_AS7341X_LowPower.h"
 #include <SparkFun_PCA9536_Arduino_Library.h>		// Get library here: https://github.com/sparkfun/SparkFun_PCA9536_Arduino_Library
 
 class SparkFun_AS7341X
@@ -42,18 +50,171 @@ private:
 	
 	bool IRLedPowered = false;
 	
+	// Non-blocking measurement state
+	AS7341X_MEASUREMENT_STATE measurementState = AS7341X_MEASUREMENT_STATE::IDLE;
+	
+	// millis() value when the current measurement step started
+	unsigned long measurementStepStart = 0;
+	
+	// micros() value when the current integration was started with SP_EN
+	unsigned long integrationStart = 0;
+	
+	// Raw channel values of the current non-blocking measurement
+	uint16_t measurementData[12];
+	
+	// ASTATUS latched with the last ADC read
+	byte lastAStatus = 0;
+	
+	// micros() value of the last ADC read
+	unsigned long lastReadMicros = 0;
+	
+	// ASTATUS of the low (F1-F4) and high (F5-F8) passes of the last measurement
+	byte passAStatus[2] = { 0, 0 };
+	
+	// True while the spectral AGC owns CFG_1
+	bool agcEnabled = false;
+	
+	// 1 / tint in ms, recomputed only after ATIME or ASTEP changed
+	float tintReciprocal = 0;
+	bool tintReciprocalValid = false;
+	
+	// 1 / (gain * tint) for the AGAIN code basicCountGain, 0xff if not computed yet
+	float basicCountScale = 0;
+	byte basicCountGain = 0xff;
+	
+	// Fixed point basic counts are (raw * fixedBasicCountFactor) >> (fixedBasicCountShift + AGAIN code - 1)
+	uint32_t fixedBasicCountFactor = 0;
+	byte fixedBasicCountShift = 0;
+	bool fixedBasicCountValid = false;
+	
+	// True when measurement steps are advanced by the INT pin instead of polling STATUS_2
+	bool interruptDriven = false;
+	
+	// Set from the user's interrupt service routine through notifyInterrupt()
+	volatile bool interruptPending = false;
+	
+	// Number of ADC channels written to the FIFO per spectral cycle
+	byte fifoChannelCount = 0;
+	
+	// Sample rate of the last flicker waveform capture in Hz
+	float flickerSampleRate = 0;
+	
+	// Background flicker detection: settings, latest result (-1 = none yet) and its sequence number
+	bool flickerDetectionEnabled = false;
+	AS7341X_GAIN flickerGain = AS7341X_GAIN::GAIN_X32;
+	int flickerResult = -1;
+	bool flickerSaturated = false;
+	uint32_t flickerSequence = 0;
+	
+	// Sequence number of the latest continuous sample, 0 if none has been captured yet
+	uint32_t sampleSequence = 0;
+	
+	// millis() value when the latest continuous sample was captured
+	unsigned long sampleTimestamp = 0;
+	
+	// True while the sensor sleeps after every spectral interrupt
+	bool sleepAfterInterrupt = false;
+	
+	// ADC compared against the spectral thresholds (CFG_12 SP_TH_CH)
+	byte thresholdChannel = 0;
+	
+	// Threshold monitoring: channels routed to ADC0 to ADC5, with the monitored one on thresholdChannel, and which
+	// half of the 12 entry layout (0 = F1-F4, 1 = F5-F8) they cover
+	bool thresholdMonitoring = false;
+	byte thresholdMonitorChannels[AS7341X_ADC_COUNT];
+	byte thresholdMonitorPass = 0;
+	
+	// Latest threshold event, its micros() timestamp and the number of events so far
+	AS7341X_THRESHOLD_EVENT thresholdEvent = AS7341X_THRESHOLD_EVENT::NONE;
+	unsigned long thresholdEventMicros = 0;
+	uint32_t thresholdEventCount = 0;
+	
 	// Sets F1 to F4 + Clear + NIR to ADCs inputs
 	void setMuxLo();
 	
 	// Sets F5 to F8 + Clear + NIR to ADCs inputs
 	void setMuxHi();	
+	
+	// Writes a SMUX RAM image stored in flash and starts the SMUX command by writing enableValue to ENABLE
+	void applySmuxTable(const byte* smuxTable, byte enableValue = 0x11);
+	
+	// Same as applySmuxTable for an image held in RAM
+	void applySmuxImage(const byte* smuxImage, byte enableValue = 0x11);
+	
+	// Builds a SMUX RAM image routing channels[i] (0 = F1 ... 9 = NIR) to ADC i, for up to six channels
+	void buildSmuxImage(const byte* channels, byte count, byte* smuxImage);
+	
+	// Waits for the SMUX command, runs one integration and reads the six ADCs. Returns false on timeout.
+	bool integrateAdcs(uint16_t* adcData);
+	
+	// Restarts the spectral engine with the LED driver (LED_ACT) in the requested state and runs one integration
+	bool integrateWithLed(bool ledOn, uint16_t* adcData);
+	
+	// Routes up to six channels to the ADCs, runs one integration and stores each result at its channel index
+	bool readChannelPass(const byte* channels, byte count, unsigned int* channelData);
 
+	// Configures SMUX for one of the predefined six channel configurations
+	void applyMuxConfig(AS7341X_MUX_CONFIG muxConfig);
+	
+	// Returns true once the SMUX command started by applySmuxTable has finished
+	bool isSmuxDone();
+	
+	// Waits for the SMUX command to finish. Returns false on timeout.
+	bool waitForSmux();
+	
+	// Returns the integration time set by ATIME and ASTEP, in microseconds
+	unsigned long getIntegrationMicros();
+	
+	// Called right after SP_EN is set: sleeps through the integration time, then reads STATUS_2 every
+	// STATUS_POLL_INTERVAL_US until AVALID is set. Returns false on timeout.
+	bool waitForSpectralData();
+	
+	// Returns true if the current measurement step has been running for longer than MEASUREMENT_TIMEOUT_MS plus the
+	// integration time
+	bool measurementStepTimedOut();
+	
+	// Consumes a pending INT pin event. Returns the STATUS bits that were set, or 0 if there was nothing to handle.
+	byte takeInterruptStatus();
+	
+	// Converts an AGAIN code (CFG_1 or ASTATUS) to the gain enumeration
+	AS7341X_GAIN gainFromCode(byte code);
+	
+	// Returns 1 / (gain * tint in ms) for an AGAIN code, recomputed only when the code or the integration time changed
+	float getBasicCountScale(byte gainCode);
+	
+	// Forces getBasicCountScale() to recompute, called whenever ATIME or ASTEP may have changed
+	void invalidateBasicCountScale();
+	
+	// Reads ASTATUS and the six ADC results (latched together) into destination. Returns ASTATUS.
+	byte readAdcData(uint16_t* destination);
+	
+	// Programs FD integration time and gain, clears FD_STATUS and sets FDEN
+	void configureFlickerDetection();
+	
+	// Reads count FIFO entries into destination using bursts of FIFO_BURST_ENTRIES
+	void readFifoEntries(uint16_t* destination, uint16_t count);
+	
+	// Fills a sample record from measurementData and the current settings
+	void fillSample(AS7341X_SAMPLE& sample, bool singlePass);
+	
+	// Programs WTIME and WLONG for a spectral cycle period as close as possible to milliseconds
+	void configureWaitTime(unsigned long milliseconds);
+	
+	// Routes the monitoring SMUX image and restarts the free-running spectral engine with a clean interrupt status
+	bool resumeThresholdMonitoring();
+	
 	// Reads single channel value after mux setup
 	uint16_t readSingleChannelValue();
 	
 	// Converts raw value to basic count value
 	float readSingleBasicCountChannelValue(uint16_t raw);
 	
+	// Converts a raw value measured with an AGAIN code to Q16.16 basic counts, using integer math only
+	uint32_t convertBasicCountFixed(uint16_t raw, byte gainCode);
+	
+	// Converts raw value to Q16.16 basic count value
+	uint32_t readSingleBasicCountChannelValueFixed(uint16_t raw);
+	
 public:
 	// Constructor
 	SparkFun_AS7341X(AS7341X_DEVICE deviceUsed = AS7341X_DEVICE::AS7341L);
@@ -67,9 +228,115 @@ public:
 	// Read all channels raw values
 	bool readAllChannels(unsigned int* channelData);
 	
+	// Reads all channels with the LED off and on and returns the difference (LED on minus ambient, same layout as readAllChannels).
+	// Both SMUX configurations are set up once: off and on for F1-F4, then on and off for F5-F8, so the LED is lit for two back to
+	// back integrations only. ambientData optionally receives the LED off reading. Don't combine with AGC, both readings need the same gain.
+	bool readAllChannelsDifferential(AS7341X_LED led, unsigned int* channelData, unsigned int* ambientData = nullptr);
+	
+	// Starts a non-blocking measurement of all channels. Call poll() until it returns true, then getResult().
+	bool startMeasurement();
+	
+	// Advances the non-blocking measurement by at most one step without waiting. Returns true when the result is ready.
+	bool poll();
+	
+	// Returns true when the non-blocking measurement has completed
+	bool isReady();
+	
+	// Returns the current state of the non-blocking measurement
+	AS7341X_MEASUREMENT_STATE getMeasurementState();
+	
+	// Copies the last non-blocking measurement into channelData (12 values, same layout as readAllChannels)
+	bool getResult(unsigned int* channelData);
+	
+	// Same as getResult, as a sample record with timestamp, gain, integration settings and saturation flags
+	bool getResult(AS7341X_SAMPLE& sample);
+	
+	// Makes poll() wait for the INT pin (SMUX done and spectral valid interrupts) instead of polling the sensor over I2C
+	void enableInterruptDrivenMeasurements();
+	
+	// Returns poll() to polling STATUS_2 over I2C
+	void disableInterruptDrivenMeasurements();
+	
+	// Call from the INT pin interrupt service routine. Only sets a flag, safe to call from an ISR.
+	void notifyInterrupt();
+	
+	// Starts free-running measurements and streams the ADCs selected in adcMask (bit 0 = ADC0 ... bit 5 = ADC5) into the on-chip FIFO
+	bool startFifoStreaming(byte adcMask, AS7341X_MUX_CONFIG muxConfig = AS7341X_MUX_CONFIG::F1_F4_CLEAR_NIR);
+	
+	// Stops FIFO streaming and the spectral engine
+	void stopFifoStreaming();
+	
+	// Moves the FIFO contents into buffer using bulk reads. Returns the number of entries moved.
+	uint16_t drainFifo(SparkFun_AS7341X_FifoBuffer& buffer);
+	
+	// Discards everything in the on-chip FIFO
+	void clearFifo();
+	
+	// Returns the number of FIFO entries written per spectral cycle
+	byte getFifoChannelCount();
+	
+	// Starts free-running measurements of one SMUX configuration, one sample every sampleIntervalMs (2.78 ms to 11.4 s).
+	// Returns false with ERROR_AS7341X_INVALID_WAIT_TIME if the resulting cycle is shorter than the integration time.
+	bool startContinuousMeasurement(unsigned long sampleIntervalMs, AS7341X_MUX_CONFIG muxConfig = AS7341X_MUX_CONFIG::F1_F4_CLEAR_NIR);
+	
+	// Stops continuous measurements
+	void stopContinuousMeasurement();
+	
+	// Fetches a new continuous sample if one is available. Never waits. Returns true when a new sample was captured.
+	bool updateContinuousMeasurement();
+	
+	// Copies the latest continuous sample (six ADC values) into channelData and returns its sequence number (0 = no sample yet)
+	uint32_t getLatestSample(unsigned int* channelData);
+	
+	// Same as getLatestSample, as a sample record (AS7341X_SAMPLE_SINGLE_PASS set)
+	uint32_t getLatestSample(AS7341X_SAMPLE& sample);
+	
+	// Returns the sequence number of the latest continuous sample
+	uint32_t getSampleSequence();
+	
+	// Returns the millis() timestamp of the latest continuous sample
+	unsigned long getSampleTimestamp();
+	
+	// Makes the sensor sleep at the end of every spectral cycle (CFG_3 SAI) until the spectral interrupt is cleared with
+	// wakeFromSleepAfterInterrupt(). Enables AINT on every cycle (APERS 0). In interrupt driven mode the interrupt is
+	// cleared as soon as it is handled, so the sensor only sleeps until the MCU services the INT pin.
+	void enableSleepAfterInterrupt();
+	
+	// Stops sleeping after interrupts and wakes the sensor if it is asleep
+	void disableSleepAfterInterrupt();
+	
+	// Returns true if sleep after interrupt is enabled
+	bool isSleepAfterInterruptEnabled();
+	
+	// Clears the spectral and SMUX interrupts, which starts the next spectral cycle when the sensor sleeps after
+	// interrupts. SAI acts on any enabled interrupt, and every SMUX command raises SINT.
+	void wakeFromSleepAfterInterrupt();
+	
+	// Lowers the current drawn while the sensor waits between spectral cycles (CFG_0 LOW_POWER)
+	void enableLowPowerIdle();
+	
+	// Returns to the normal idle mode
+	void disableLowPowerIdle();
+	
+	// Returns the spectral cycle period programmed by startContinuousMeasurement (WTIME and WLONG), in milliseconds
+	float getWaitTime();
+	
 	// Read all channels basic counts. Further information can be found in AN000633, page 7
 	bool readAllChannelsBasicCounts(float* channelDataBasicCounts);
 	
+	// Reads any subset of the 10 optical channels (AS7341X_CHANNEL_* bits) with as few integrations as possible:
+	// one for up to six channels, two for more. channelData has 10 entries (F1 to F8, Clear, NIR), only the
+	// selected ones are written.
+	bool readChannels(uint16_t channelMask, unsigned int* channelData);
+	
+	// Applies a SMUX image stored in flash (see AS7341X_SMUX_IMAGE), runs one integration and reads ADC0 to ADC5
+	// into adcData (6 entries)
+	bool readSmuxTable(const byte* smuxTable, unsigned int* adcData);
+	
+	// Same as readAllChannelsBasicCounts, in Q16.16 fixed point (divide by 65536 for basic counts). Uses no floating point.
+	// Values saturate at 0xffffffff.
+	bool readAllChannelsBasicCountsFixed(uint32_t* channelDataBasicCounts);
+	
 	// Enable AS7341X
 	void enable_AS7341X();
 	
@@ -118,8 +385,27 @@ public:
 	// Set ADC gain
 	void setGain(AS7341X_GAIN gain = AS7341X_GAIN::GAIN_X256);
 	
-	// Return ADC gain
+	// Return ADC gain. With AGC enabled this is the gain the sensor will use for the next cycle.
 	AS7341X_GAIN getGain();
+	
+	// Enables the on-chip spectral AGC. The sensor adjusts the gain after every cycle, never above maxGain.
+	// Gain is lowered when a channel goes over highHysteresis and raised when all go under lowHysteresis.
+	void enableAutomaticGain(AS7341X_GAIN maxGain = AS7341X_GAIN::GAIN_X256,
+		AS7341X_AGC_LOW_HYSTERESIS lowHysteresis = AS7341X_AGC_LOW_HYSTERESIS::PERCENT_50,
+		AS7341X_AGC_HIGH_HYSTERESIS highHysteresis = AS7341X_AGC_HIGH_HYSTERESIS::PERCENT_87_5);
+	
+	// Disables the spectral AGC. The gain stays at whatever value the AGC left in CFG_1.
+	void disableAutomaticGain();
+	
+	// Returns true if the spectral AGC is enabled
+	bool isAutomaticGainEnabled();
+	
+	// Returns the gain actually used by the last measurement, as reported by ASTATUS.
+	// pass 0 covers F1-F4 (and single channel or continuous reads), pass 1 covers F5-F8.
+	AS7341X_GAIN getMeasurementGain(byte pass = 0);
+	
+	// Returns true if the last measurement pass saturated (ASTATUS ASAT)
+	bool isMeasurementSaturated(byte pass = 0);
 
 	// Enables interrupt pin functionality
 	void enablePinInterupt();
@@ -136,6 +422,18 @@ public:
 	// Writes register
 	void writeRegister(byte reg, byte value);
 	
+	// Forces cached configuration registers to be read back from the device on next use
+	void resyncRegisterCache();
+	
+#if AS7341X_IO_STATS
+	// Copies the AS7341X I2C counters, overall or for one call site. PCA9536 traffic is not included.
+	void getIOStats(SparkFun_AS7341X_IOStats& stats);
+	void getIOStats(AS7341X_IO_SITE site, SparkFun_AS7341X_IOStats& stats);
+	
+	// Zeroes the I2C counters
+	void resetIOStats();
+#endif
+	
 	// Sets GPIO as input
 	void setGpioPinInput();
 	
@@ -210,6 +508,36 @@ public:
 	
 	// Read basic count value of NIR channel
 	float readBasicCountNIR();
+	
+	// Read basic count value of 415 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed415nm();
+	
+	// Read basic count value of 445 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed445nm();
+	
+	// Read basic count value of 480 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed480nm();
+	
+	// Read basic count value of 515 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed515nm();
+	
+	// Read basic count value of 555 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed555nm();
+	
+	// Read basic count value of 590 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed590nm();
+	
+	// Read basic count value of 630 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed630nm();
+	
+	// Read basic count value of 680 nm channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixed680nm();
+	
+	// Read basic count value of clear channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixedClear();
+	
+	// Read basic count value of NIR channel, in Q16.16 fixed point
+	uint32_t readBasicCountFixedNIR();
 
 	// Sets the low threshold value
 	void setLowThreshold(unsigned int threshold);
@@ -238,6 +566,12 @@ public:
 	// Returns true if AS7341X has SP_EN set
 	bool isMeasurementEnabled();
 		
+	// Selects the ADC (0 to 4) compared against the thresholds (CFG_12 SP_TH_CH). ADC5 cannot be selected.
+	void setThresholdChannel(byte adc);
+	
+	// Returns the ADC compared against the thresholds
+	byte getThresholdChannel();
+	
 	// Enable threshold interrupt generation
 	void enableThresholdInterrupt();
 	
@@ -253,9 +587,64 @@ public:
 	// Returns true if the channel value is higher than the high threshold value
 	bool highThresholdInterruptSet();
 	
-	// AS7341 specific function - returns 100 for 100 Hz, 120 for 120 Hz, 0 for unknown and -1 for invalid device
+	// Starts event driven monitoring of one optical channel (0 = F1 ... 7 = F8, 8 = Clear, 9 = NIR). The sensor free-runs one cycle every
+	// intervalMs with the channel's half of the spectrum routed to the ADCs and the channel on the threshold ADC, and only pulls INT low
+	// once the channel has been outside lowThreshold..highThreshold for persistence (APERS, 1 to 15) cycles. It then sleeps (SAI) so the
+	// data of that cycle is kept. Needs the INT pin: call notifyInterrupt() from its interrupt service routine. Until an event, nothing
+	// is read over I2C. Don't run other measurements while monitoring.
+	bool startThresholdMonitoring(byte channel, unsigned int lowThreshold, unsigned int highThreshold, byte persistence = 1,
+		unsigned long intervalMs = 100);
+	
+	// Stops threshold monitoring and the spectral engine
+	void stopThresholdMonitoring();
+	
+	// Returns true while threshold monitoring is running
+	bool isThresholdMonitoringEnabled();
+	
+	// Handles a pending INT event without touching the bus otherwise. On a threshold event, reads the monitored half of the spectrum
+	// captured by the cycle that fired, measures the other half with one more integration and resumes monitoring. Returns true on an event.
+	bool updateThresholdMonitoring();
+	
+	// Copies the spectrum of the latest event (same layout as readAllChannels, timestamp of the cycle that fired) and returns which
+	// side of the window the channel left through, NONE if there was no event yet
+	AS7341X_THRESHOLD_EVENT getThresholdEvent(AS7341X_SAMPLE& sample);
+	
+	// Returns the number of threshold events since monitoring started
+	uint32_t getThresholdEventCount();
+	
+	// AS7341 specific function - waits for a flicker detection result. Returns 100 for 100 Hz, 120 for 120 Hz, 0 for unknown and -1 for invalid device.
+	// Returns the latest background result instead while startFlickerDetection() is active.
 	int getFlickerFrequency();
 	
+	// AS7341 specific function - starts flicker detection in the background, alongside spectral measurements. ADC5 is routed to the
+	// flicker photodiode in every SMUX configuration, so NIR (channelData[5] and [11]) reads 0 and readChannels uses five ADCs per pass.
+	bool startFlickerDetection(AS7341X_GAIN gain = AS7341X_GAIN::GAIN_X32);
+	
+	// Stops background flicker detection. The next SMUX configuration gives ADC5 back to spectral measurements.
+	void stopFlickerDetection();
+	
+	// Returns true if background flicker detection is running
+	bool isFlickerDetectionEnabled();
+	
+	// Checks FD_STATUS once and latches the result if a new one is valid. Never waits. Returns true when a new result was captured.
+	bool updateFlickerDetection();
+	
+	// Returns the latest background flicker result: 100 for 100 Hz, 120 for 120 Hz, 0 for unknown and -1 if there is none yet
+	int getFlickerResult();
+	
+	// Returns true if the flicker photodiode saturated during the latest background result
+	bool isFlickerSaturated();
+	
+	// Returns the sequence number of the latest background flicker result (0 = none yet)
+	uint32_t getFlickerSequence();
+	
+	// AS7341 specific function - streams count raw flicker photodiode samples through the FIFO into samples at about sampleRate Hz.
+	// Returns false on an AS7341L, on a timeout or if the FIFO overflowed (the waveform would have a gap).
+	bool captureFlickerWaveform(uint16_t* samples, uint16_t count, uint16_t sampleRate = 4000, AS7341X_GAIN gain = AS7341X_GAIN::GAIN_X32);
+	
+	// Returns the exact sample rate of the last flicker waveform capture, in Hz
+	float getFlickerSampleRate();
+	
 };
 
 #endif // ! __SparkFun_AS7341X_LIBRARY__
\ No newline at end of file
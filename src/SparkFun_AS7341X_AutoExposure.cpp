@@ -0,0 +1,230 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the software auto-exposure controller of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_AutoExposure.h"
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Gain factor for an AGAIN code, 0 (0.5x) to 10 (512x)
+static float gainOf(byte code)
+{
+	if (code == 0)
+		return 0.5f;
+	
+	return float(1UL << (code - 1));
+}
+
+void SparkFun_AS7341X_AutoExposure::setTarget(byte targetPercent, byte tolerancePercent)
+{
+	if (targetPercent < 1)
+		targetPercent = 1;
+	if (targetPercent > 95)
+		targetPercent = 95;
+	
+	_targetPercent = targetPercent;
+	_tolerancePercent = tolerancePercent;
+}
+
+void SparkFun_AS7341X_AutoExposure::setMaxGain(AS7341X_GAIN maxGain)
+{
+	if (maxGain == AS7341X_GAIN::GAIN_INVALID)
+		maxGain = AS7341X_GAIN::GAIN_X512;
+	
+	_maxGain = maxGain;
+}
+
+void SparkFun_AS7341X_AutoExposure::setMaxIntegrationTime(unsigned long microseconds)
+{
+	// One integration step is 2.78 us
+	_maxIntegrationSteps = (uint32_t)(microseconds / 2.78f);
+	if (_maxIntegrationSteps < 1)
+		_maxIntegrationSteps = 1;
+}
+
+void SparkFun_AS7341X_AutoExposure::setBaseIntegration(byte aTime, unsigned int aStep)
+{
+	_baseATime = aTime;
+	_baseAStep = aStep;
+	_baseValid = true;
+}
+
+bool SparkFun_AS7341X_AutoExposure::update(const unsigned int* rawCounts, byte channelCount, bool saturated)
+{
+	AS7341X_EXPOSURE_DECISION decision;
+	
+	decision.aTime = _sensor->getATIME();
+	decision.aStep = _sensor->getASTEP();
+	decision.gain = _sensor->getGain();
+	if (!_baseValid)
+		setBaseIntegration(decision.aTime, decision.aStep);
+	
+	// Full scale is (ATIME + 1) x (ASTEP + 1), limited by the 16 bit data registers
+	uint32_t steps = uint32_t(decision.aTime + 1) * (uint32_t(decision.aStep) + 1);
+	decision.fullScale = (steps > 65535) ? 65535 : steps;
+	
+	decision.peak = 0;
+	for (byte i = 0; i < channelCount; i++)
+		if (rawCounts[i] > decision.peak)
+			decision.peak = rawCounts[i];
+	
+	decision.saturated = saturated || (decision.peak >= decision.fullScale);
+	
+	float fill = float(decision.peak) / decision.fullScale;
+	float target = _targetPercent / 100.0f;
+	float tolerance = _tolerancePercent / 100.0f;
+	decision.accepted = !decision.saturated && (fill >= target - tolerance) && (fill <= target + tolerance);
+	
+	decision.nextATime = decision.aTime;
+	decision.nextAStep = decision.aStep;
+	decision.nextGain = decision.gain;
+	decision.unreachable = false;
+	
+	if (decision.accepted)
+	{
+		record(decision);
+		return true;
+	}
+	
+	// Counts per integration step at 1x. A saturated reading only gives a lower bound,
+	// so assume the scene is AUTO_EXPOSURE_SATURATION_FACTOR times over full scale.
+	float gain = gainOf(byte(decision.gain));
+	float rate;
+	if (decision.saturated)
+		rate = float(decision.fullScale) * AUTO_EXPOSURE_SATURATION_FACTOR / (gain * steps);
+	else
+		rate = float(decision.peak ? decision.peak : 1) / (gain * steps);
+	
+	// Fill level only depends on gain while the base integration is within 65535 steps, longer ones add headroom
+	uint32_t baseSteps = uint32_t(_baseATime + 1) * (uint32_t(_baseAStep) + 1);
+	float baseBoost = (baseSteps > 65535) ? float(baseSteps) / 65535 : 1.0f;
+	
+	// Highest gain that doesn't overshoot the target
+	byte gainCode = 0;
+	for (byte code = byte(_maxGain); code > 0; code--)
+	{
+		if (rate * gainOf(code) * baseBoost <= target)
+		{
+			gainCode = code;
+			break;
+		}
+	}
+	
+	decision.nextGain = AS7341X_GAIN(gainCode);
+	decision.nextATime = _baseATime;
+	decision.nextAStep = _baseAStep;
+	
+	// Too dark even at maximum gain: integrate longer, past 65535 steps the ceiling no longer grows with time
+	if (gainCode == byte(_maxGain) && rate * gainOf(gainCode) * baseBoost < target - tolerance)
+	{
+		float wanted = target * 65535 / (rate * gainOf(gainCode));
+		uint32_t nextSteps = (wanted > _maxIntegrationSteps) ? _maxIntegrationSteps : uint32_t(wanted);
+		
+		if (nextSteps > baseSteps)
+		{
+			// Keep ASTEP and stretch ATIME first, then ASTEP once ATIME is at its maximum
+			uint32_t aTime = (nextSteps + _baseAStep) / (uint32_t(_baseAStep) + 1);
+			if (aTime <= 256)
+			{
+				decision.nextATime = byte(aTime - 1);
+				decision.nextAStep = _baseAStep;
+			}
+			else
+			{
+				uint32_t aStep = (nextSteps + 255) / 256;
+				if (aStep > 65535)
+					aStep = 65535;
+				decision.nextATime = 255;
+				decision.nextAStep = uint16_t(aStep - 1);
+			}
+		}
+	}
+	
+	// Too bright even at minimum gain: a base longer than 65535 steps can be shortened down to 65535 steps, where
+	// the fill level stops depending on integration time. Shorter integration would only cost resolution.
+	if (gainCode == 0 && baseSteps > 65535 && rate * gainOf(0) * baseBoost > target + tolerance)
+	{
+		float wanted = target * 65535 / (rate * gainOf(0));
+		uint32_t nextSteps = (wanted < 65535) ? 65535 : uint32_t(wanted);
+		
+		// Keep ASTEP and shorten ATIME, rounding up so the integration never drops below nextSteps
+		uint32_t aTime = (nextSteps + _baseAStep) / (uint32_t(_baseAStep) + 1);
+		if (aTime < uint32_t(_baseATime) + 1)
+			decision.nextATime = byte(aTime - 1);
+	}
+	
+	// Fill level expected at the next settings. Still outside the window at a gain limit means the scene is out of
+	// range, but a saturated reading only bounds the rate from below: it proves it once the settings stop changing.
+	uint32_t plannedSteps = uint32_t(decision.nextATime + 1) * (uint32_t(decision.nextAStep) + 1);
+	float plannedFill = rate * gainOf(gainCode) * ((plannedSteps > 65535) ? float(plannedSteps) / 65535 : 1.0f);
+	bool outOfRange = (gainCode == 0 && plannedFill > target + tolerance) ||
+		(gainCode == byte(_maxGain) && plannedFill < target - tolerance);
+	bool unchanged = decision.nextGain == decision.gain && decision.nextATime == decision.aTime &&
+		decision.nextAStep == decision.aStep;
+	decision.unreachable = outOfRange && (!decision.saturated || unchanged);
+	
+	// Unchanged values are filtered out by the register shadow
+	_sensor->setGain(decision.nextGain);
+	_sensor->setATIME(decision.nextATime);
+	_sensor->setASTEP(decision.nextAStep);
+	
+	record(decision);
+	return false;
+}
+
+bool SparkFun_AS7341X_AutoExposure::readAllChannels(unsigned int* channelData, byte maxReads)
+{
+	for (byte i = 0; i < maxReads; i++)
+	{
+		if (!_sensor->readAllChannels(channelData))
+			return false;
+		
+		bool saturated = _sensor->isMeasurementSaturated(0) || _sensor->isMeasurementSaturated(1);
+		if (update(channelData, 12, saturated))
+			return true;
+	}
+	
+	return false;
+}
+
+void SparkFun_AS7341X_AutoExposure::record(const AS7341X_EXPOSURE_DECISION& decision)
+{
+	_history[_historyHead] = decision;
+	_historyHead = (_historyHead + 1) % AUTO_EXPOSURE_HISTORY_LENGTH;
+	if (_historyCount < AUTO_EXPOSURE_HISTORY_LENGTH)
+		_historyCount++;
+}
+
+byte SparkFun_AS7341X_AutoExposure::getHistoryCount()
+{
+	return _historyCount;
+}
+
+bool SparkFun_AS7341X_AutoExposure::getDecision(byte age, AS7341X_EXPOSURE_DECISION& decision)
+{
+	if (age >= _historyCount)
+		return false;
+	
+	byte index = (_historyHead + AUTO_EXPOSURE_HISTORY_LENGTH - 1 - age) % AUTO_EXPOSURE_HISTORY_LENGTH;
+	decision = _history[index];
+	return true;
+}
+
+void SparkFun_AS7341X_AutoExposure::clearHistory()
+{
+	_historyHead = 0;
+	_historyCount = 0;
+}
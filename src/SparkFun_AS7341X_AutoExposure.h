@@ -0,0 +1,116 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the software auto-exposure controller of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_AUTO_EXPOSURE__
+#define __SparkFun_AS7341X_AUTO_EXPOSURE__
+
+#include <Arduino.h>
+#include "SparkFun_AS7341X_Constants.h"
+
+class SparkFun_AS7341X;
+
+// One auto-exposure step: the settings a reading was taken with, what it looked like and what was chosen next
+struct AS7341X_EXPOSURE_DECISION
+{
+	byte aTime;
+	uint16_t aStep;
+	AS7341X_GAIN gain;
+	
+	// Highest raw count of the reading and the saturation ceiling for its settings
+	uint16_t peak;
+	uint16_t fullScale;
+	bool saturated;
+	
+	// True if the reading was within the target window. Settings are left alone in that case.
+	bool accepted;
+	
+	// Settings programmed for the next reading
+	byte nextATime;
+	uint16_t nextAStep;
+	AS7341X_GAIN nextGain;
+	
+	// True if the scene is too dark or too bright to reach the target window within the gain and integration
+	// limits. The next settings are then the closest ones to the target.
+	bool unreachable;
+};
+
+// Host side auto-exposure. Counts scale linearly with gain and integration steps, so a single reading is
+// enough to predict the gain (and, in very dark or bright scenes, the integration time) that lands the brightest channel
+// on the target fill level. Don't combine it with the on-chip AGC, both would fight over CFG_1.
+class SparkFun_AS7341X_AutoExposure
+{
+private:
+	SparkFun_AS7341X* _sensor;
+	
+	// Target fill level of the brightest channel and accepted deviation, in percent of full scale
+	byte _targetPercent = 60;
+	byte _tolerancePercent = 25;
+	
+	AS7341X_GAIN _maxGain = AS7341X_GAIN::GAIN_X512;
+	
+	// Longest integration allowed when the maximum gain is not enough, in integration steps
+	uint32_t _maxIntegrationSteps = 71942;
+	
+	// Integration time the controller returns to whenever gain alone can reach the target
+	byte _baseATime = 0;
+	uint16_t _baseAStep = 0;
+	bool _baseValid = false;
+	
+	// Circular decision history, _historyHead is the next slot to write
+	AS7341X_EXPOSURE_DECISION _history[AUTO_EXPOSURE_HISTORY_LENGTH];
+	byte _historyHead = 0;
+	byte _historyCount = 0;
+	
+	// Adds a decision to the history, dropping the oldest one if full
+	void record(const AS7341X_EXPOSURE_DECISION& decision);
+	
+public:
+	// Constructor, binds the controller to a sensor
+	SparkFun_AS7341X_AutoExposure(SparkFun_AS7341X& sensor) : _sensor(&sensor) {}
+	
+	// Sets the target fill level of the brightest channel and the accepted deviation, both in percent of full scale
+	void setTarget(byte targetPercent = 60, byte tolerancePercent = 25);
+	
+	// Sets the highest gain the controller may select
+	void setMaxGain(AS7341X_GAIN maxGain = AS7341X_GAIN::GAIN_X512);
+	
+	// Sets the longest integration time the controller may select, in microseconds
+	void setMaxIntegrationTime(unsigned long microseconds = 200000);
+	
+	// Sets the integration time used while gain alone is enough. Defaults to the sensor settings on the first update.
+	void setBaseIntegration(byte aTime, unsigned int aStep);
+	
+	// Evaluates raw counts measured with the current settings and programs the settings for the next reading.
+	// Returns true if the reading was within the target window and can be used as is.
+	bool update(const unsigned int* rawCounts, byte channelCount, bool saturated = false);
+	
+	// Reads all channels, adjusting exposure between reads, until a reading is accepted or maxReads is reached.
+	// channelData always holds the last reading. Returns true if it was accepted.
+	bool readAllChannels(unsigned int* channelData, byte maxReads = 3);
+	
+	// Returns the number of decisions in the history
+	byte getHistoryCount();
+	
+	// Copies a decision from the history, age 0 being the latest. Returns false if there is no such decision.
+	bool getDecision(byte age, AS7341X_EXPOSURE_DECISION& decision);
+	
+	// Empties the decision history
+	void clearHistory();
+};
+
+#endif // ! __SparkFun_AS7341X_AUTO_EXPOSURE__
@@ -0,0 +1,223 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the data buffers used by the streaming functions of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_Buffers.h"
+
+// Index accesses shared between producer and consumer. The release store publishes the data written before it and the
+// acquire load makes that data visible before it is read, also across cores (ESP32). AVR is single core and has no
+// __atomic library calls for 16 bit values, so a compiler barrier is enough there.
+template<typename T> static inline T loadAcquire(volatile T& index)
+{
+#if defined(__AVR__)
+	T value = index;
+	__asm__ __volatile__("" ::: "memory");
+	return value;
+#else
+	return __atomic_load_n(&index, __ATOMIC_ACQUIRE);
+#endif
+}
+
+template<typename T> static inline void storeRelease(volatile T& index, T value)
+{
+#if defined(__AVR__)
+	__asm__ __volatile__("" ::: "memory");
+	index = value;
+#else
+	__atomic_store_n(&index, value, __ATOMIC_RELEASE);
+#endif
+}
+
+void SparkFun_AS7341X_FifoBuffer::begin(uint16_t* storage, uint16_t capacity)
+{
+	_storage = storage;
+	_capacity = capacity;
+	clear();
+	clearOverflow();
+}
+
+uint16_t SparkFun_AS7341X_FifoBuffer::available()
+{
+	if (_capacity == 0)
+		return 0;
+	uint16_t head = loadAcquire(_head);
+	uint16_t tail = loadAcquire(_tail);
+	if (head >= tail)
+		return head - tail;
+	return _capacity - tail + head;
+}
+
+uint16_t SparkFun_AS7341X_FifoBuffer::freeSpace()
+{
+	if (_capacity == 0)
+		return 0;
+	return _capacity - 1 - available();
+}
+
+bool SparkFun_AS7341X_FifoBuffer::push(uint16_t value)
+{
+	if (freeSpace() == 0)
+	{
+		_overflow = true;
+		return false;
+	}
+	
+	uint16_t head = _head;
+	_storage[head] = value;
+	head++;
+	if (head == _capacity)
+		head = 0;
+	storeRelease(_head, head);
+	return true;
+}
+
+bool SparkFun_AS7341X_FifoBuffer::pop(uint16_t& value)
+{
+	uint16_t tail = _tail;
+	if (tail == loadAcquire(_head))
+		return false;
+	
+	value = _storage[tail];
+	tail++;
+	if (tail == _capacity)
+		tail = 0;
+	storeRelease(_tail, tail);
+	return true;
+}
+
+void SparkFun_AS7341X_FifoBuffer::clear()
+{
+	_head = 0;
+	_tail = 0;
+}
+
+void SparkFun_AS7341X_FifoBuffer::setOverflow()
+{
+	_overflow = true;
+}
+
+bool SparkFun_AS7341X_FifoBuffer::overflowed()
+{
+	return _overflow;
+}
+
+void SparkFun_AS7341X_FifoBuffer::clearOverflow()
+{
+	_overflow = false;
+}
+
+void SparkFun_AS7341X_SampleBuffer::begin(AS7341X_SAMPLE* storage, byte capacity)
+{
+	_storage = storage;
+	_capacity = capacity;
+	_head = 0;
+	_tail = 0;
+	_dropped = 0;
+}
+
+byte SparkFun_AS7341X_SampleBuffer::next(byte index)
+{
+	index++;
+	if (index == _capacity)
+		index = 0;
+	return index;
+}
+
+byte SparkFun_AS7341X_SampleBuffer::available()
+{
+	if (_capacity == 0)
+		return 0;
+	byte head = loadAcquire(_head);
+	byte tail = loadAcquire(_tail);
+	if (head >= tail)
+		return head - tail;
+	return _capacity - tail + head;
+}
+
+byte SparkFun_AS7341X_SampleBuffer::freeSpace()
+{
+	if (_capacity == 0)
+		return 0;
+	return _capacity - 1 - available();
+}
+
+AS7341X_SAMPLE* SparkFun_AS7341X_SampleBuffer::reserve()
+{
+	if (_capacity == 0 || next(_head) == loadAcquire(_tail))
+		return nullptr;
+	
+	return &_storage[_head];
+}
+
+void SparkFun_AS7341X_SampleBuffer::commit()
+{
+	// The record must be complete before the consumer can see the new head
+	storeRelease(_head, next(_head));
+}
+
+bool SparkFun_AS7341X_SampleBuffer::push(const AS7341X_SAMPLE& sample)
+{
+	AS7341X_SAMPLE* slot = reserve();
+	if (slot == nullptr)
+	{
+		_dropped = _dropped + 1;
+		return false;
+	}
+	
+	*slot = sample;
+	commit();
+	return true;
+}
+
+const AS7341X_SAMPLE* SparkFun_AS7341X_SampleBuffer::peek()
+{
+	if (_tail == loadAcquire(_head))
+		return nullptr;
+	
+	return &_storage[_tail];
+}
+
+void SparkFun_AS7341X_SampleBuffer::release()
+{
+	if (_tail == loadAcquire(_head))
+		return;
+	
+	// Done with the record before the producer may reuse the slot
+	storeRelease(_tail, next(_tail));
+}
+
+bool SparkFun_AS7341X_SampleBuffer::pop(AS7341X_SAMPLE& sample)
+{
+	const AS7341X_SAMPLE* slot = peek();
+	if (slot == nullptr)
+		return false;
+	
+	sample = *slot;
+	release();
+	return true;
+}
+
+void SparkFun_AS7341X_SampleBuffer::clear()
+{
+	// Only the consumer's index moves, so this is safe while the producer is running
+	storeRelease(_tail, loadAcquire(_head));
+}
+
+uint16_t SparkFun_AS7341X_SampleBuffer::getDroppedCount()
+{
+	return _dropped;
+}
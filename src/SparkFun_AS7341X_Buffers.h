@@ -0,0 +1,146 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the data buffers used by the streaming functions of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_BUFFERS__
+#define __SparkFun_AS7341X_BUFFERS__
+
+#include <Arduino.h>
+
+// Sample record flags
+const byte AS7341X_SAMPLE_SATURATED_LOW = 0x01;		// F1-F4 pass (or the only pass) saturated
+const byte AS7341X_SAMPLE_SATURATED_HIGH = 0x02;	// F5-F8 pass saturated
+const byte AS7341X_SAMPLE_SINGLE_PASS = 0x04;		// Only channels[0] to channels[5] hold data (continuous mode)
+
+// One measurement with everything needed to convert it later
+struct AS7341X_SAMPLE
+{
+	// micros() when the data was read from the sensor
+	uint32_t timestamp;
+	
+	// Raw counts, same layout as readAllChannels()
+	uint16_t channels[12];
+	
+	// Integration settings
+	uint16_t aStep;
+	byte aTime;
+	
+	// AGAIN codes actually used (0 = 0.5x ... 10 = 512x): F1-F4 pass in bits 3:0, F5-F8 pass in bits 7:4
+	byte gain;
+	
+	// AS7341X_SAMPLE_* flags
+	byte flags;
+};
+
+// Ring buffer of raw 16 bit FIFO entries backed by caller supplied storage
+class SparkFun_AS7341X_FifoBuffer
+{
+private:
+	uint16_t* _storage = nullptr;
+	uint16_t _capacity = 0;
+	volatile uint16_t _head = 0;
+	volatile uint16_t _tail = 0;
+	bool _overflow = false;
+	
+public:
+	// Default constructor
+	SparkFun_AS7341X_FifoBuffer() {}
+	
+	// Attaches the buffer to storage able to hold capacity entries. One slot is kept free to tell full from empty.
+	void begin(uint16_t* storage, uint16_t capacity);
+	
+	// Returns the number of entries waiting to be read
+	uint16_t available();
+	
+	// Returns the number of entries that can still be pushed
+	uint16_t freeSpace();
+	
+	// Adds an entry. Returns false and flags an overflow if the buffer is full.
+	bool push(uint16_t value);
+	
+	// Removes the oldest entry. Returns false if the buffer is empty.
+	bool pop(uint16_t& value);
+	
+	// Discards all entries
+	void clear();
+	
+	// Flags an overflow, e.g. when the sensor's own FIFO lost data
+	void setOverflow();
+	
+	// Returns true if data has been lost since the last clearOverflow()
+	bool overflowed();
+	
+	// Clears the overflow flag
+	void clearOverflow();
+};
+
+// Lock-free single producer, single consumer ring of sample records backed by caller supplied storage.
+// One side (e.g. an interrupt or a background task) pushes, the other pops, without disabling interrupts.
+// Indices are single bytes so they are read and written atomically on 8 bit MCUs too.
+class SparkFun_AS7341X_SampleBuffer
+{
+private:
+	AS7341X_SAMPLE* _storage = nullptr;
+	byte _capacity = 0;
+	volatile byte _head = 0;
+	volatile byte _tail = 0;
+	
+	// Samples the producer had to drop because the buffer was full. Only written by the producer.
+	volatile uint16_t _dropped = 0;
+	
+	// Returns index + 1, wrapping at capacity
+	byte next(byte index);
+	
+public:
+	// Default constructor
+	SparkFun_AS7341X_SampleBuffer() {}
+	
+	// Attaches the buffer to storage able to hold capacity records (2 to 255). One slot is kept free to tell full from empty.
+	void begin(AS7341X_SAMPLE* storage, byte capacity);
+	
+	// Returns the number of samples waiting to be read
+	byte available();
+	
+	// Returns the number of samples that can still be pushed
+	byte freeSpace();
+	
+	// Producer: copies a sample in. Returns false and counts a dropped sample if the buffer is full.
+	bool push(const AS7341X_SAMPLE& sample);
+	
+	// Producer: returns the slot to fill in place, or nullptr if the buffer is full. Call commit() once filled.
+	AS7341X_SAMPLE* reserve();
+	
+	// Producer: publishes the slot returned by reserve()
+	void commit();
+	
+	// Consumer: copies the oldest sample out. Returns false if the buffer is empty.
+	bool pop(AS7341X_SAMPLE& sample);
+	
+	// Consumer: returns the oldest sample without removing it, or nullptr if the buffer is empty. Call release() when done.
+	const AS7341X_SAMPLE* peek();
+	
+	// Consumer: removes the sample returned by peek()
+	void release();
+	
+	// Consumer: discards all waiting samples
+	void clear();
+	
+	// Returns the number of samples dropped because the buffer was full
+	uint16_t getDroppedCount();
+};
+
+#endif // ! __SparkFun_AS7341X_BUFFERS__
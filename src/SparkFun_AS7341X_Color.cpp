@@ -0,0 +1,182 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the colorimetry engine of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_Color.h"
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+// Least squares fit of the CIE 1931 2 degree observer to the nominal F1-F8 responses (Gaussian, datasheet peaks and FWHM).
+// CLEAR and NIR are left out. Off by less than 0.002 in x and y for Planckian light from 2856 K to 6500 K.
+static const float defaultMatrix[AS7341X_COLOR_ROWS][AS7341X_CHANNEL_COUNT] PROGMEM =
+{
+	{ 0.07317f, 0.38404f, 0.09534f, -0.00163f, 0.40296f, 0.92961f, 0.60383f, -0.02793f, 0.0f, 0.0f },
+	{ 0.00031f, 0.02945f, 0.04671f, 0.58738f, 0.95150f, 0.62213f, 0.22359f, -0.00476f, 0.0f, 0.0f },
+	{ 0.32538f, 1.92865f, 0.86349f, -0.01188f, 0.01954f, -0.00587f, 0.00151f, -0.00036f, 0.0f, 0.0f }
+};
+
+// Position of each channel in the readAllChannelsBasicCounts layout (4 and 5 duplicate CLEAR and NIR)
+static const byte channelIndex[AS7341X_CHANNEL_COUNT] = { 0, 1, 2, 3, 6, 7, 8, 9, 10, 11 };
+
+// McCamy's approximation, good from about 2000 K to 12500 K. Returns 0 outside of that.
+static float correlatedColorTemperature(float x, float y)
+{
+	if (y >= 0.1858f)
+	{
+		float n = (x - 0.3320f) / (0.1858f - y);
+		float cct = ((449.0f * n + 3525.0f) * n + 6823.3f) * n + 5520.33f;
+		if (cct >= 1000.0f && cct <= 25000.0f)
+			return cct;
+	}
+	
+	return 0.0f;
+}
+
+SparkFun_AS7341X_Colorimetry::SparkFun_AS7341X_Colorimetry()
+{
+	resetMatrix();
+}
+
+void SparkFun_AS7341X_Colorimetry::setMatrix(const float* matrix)
+{
+	memcpy(_matrix, matrix, sizeof(_matrix));
+}
+
+void SparkFun_AS7341X_Colorimetry::setMatrix_P(const float* matrix)
+{
+	memcpy_P(_matrix, matrix, sizeof(_matrix));
+}
+
+void SparkFun_AS7341X_Colorimetry::getMatrix(float* matrix)
+{
+	memcpy(matrix, _matrix, sizeof(_matrix));
+}
+
+void SparkFun_AS7341X_Colorimetry::resetMatrix()
+{
+	setMatrix_P(&defaultMatrix[0][0]);
+	_luxScale = 1.0f;
+}
+
+void SparkFun_AS7341X_Colorimetry::setLuxScale(float scale)
+{
+	_luxScale = scale;
+}
+
+float SparkFun_AS7341X_Colorimetry::getLuxScale()
+{
+	return _luxScale;
+}
+
+bool SparkFun_AS7341X_Colorimetry::calibrateLux(const float* basicCounts, float referenceLux)
+{
+	AS7341X_COLOR color;
+	convert(basicCounts, color);
+	if (color.Y <= 0.0f)
+		return false;
+	
+	_luxScale = referenceLux / color.Y;
+	return true;
+}
+
+void SparkFun_AS7341X_Colorimetry::derive(AS7341X_COLOR& color)
+{
+	float sum = color.X + color.Y + color.Z;
+	if (sum > 0.0f)
+	{
+		color.x = color.X / sum;
+		color.y = color.Y / sum;
+		color.cct = correlatedColorTemperature(color.x, color.y);
+	}
+	else
+	{
+		color.x = 0.0f;
+		color.y = 0.0f;
+		color.cct = 0.0f;
+	}
+	
+	color.lux = color.Y * _luxScale;
+}
+
+void SparkFun_AS7341X_Colorimetry::convert(const float* basicCounts, AS7341X_COLOR& color)
+{
+	float* tristimulus[AS7341X_COLOR_ROWS] = { &color.X, &color.Y, &color.Z };
+	
+	for (byte row = 0; row < AS7341X_COLOR_ROWS; row++)
+	{
+		float value = 0.0f;
+		for (byte channel = 0; channel < AS7341X_CHANNEL_COUNT; channel++)
+			value += _matrix[row][channel] * basicCounts[channelIndex[channel]];
+		*tristimulus[row] = value;
+	}
+	
+	derive(color);
+}
+
+void SparkFun_AS7341X_Colorimetry::convert(AS7341X_COLOR_BATCH& batch)
+{
+	float* tristimulus[AS7341X_COLOR_ROWS] = { batch.X, batch.Y, batch.Z };
+	
+	// One pass per matrix entry over contiguous arrays, skipping zero coefficients
+	for (byte row = 0; row < AS7341X_COLOR_ROWS; row++)
+	{
+		float* output = tristimulus[row];
+		for (uint16_t i = 0; i < batch.count; i++)
+			output[i] = 0.0f;
+		
+		for (byte channel = 0; channel < AS7341X_CHANNEL_COUNT; channel++)
+		{
+			float coefficient = _matrix[row][channel];
+			const float* input = batch.channel[channel];
+			if (coefficient == 0.0f || input == nullptr)
+				continue;
+			
+			for (uint16_t i = 0; i < batch.count; i++)
+				output[i] += coefficient * input[i];
+		}
+	}
+	
+	if (batch.x == nullptr && batch.y == nullptr && batch.lux == nullptr && batch.cct == nullptr)
+		return;
+	
+	for (uint16_t i = 0; i < batch.count; i++)
+	{
+		AS7341X_COLOR color;
+		color.X = batch.X[i];
+		color.Y = batch.Y[i];
+		color.Z = batch.Z[i];
+		derive(color);
+		
+		if (batch.x != nullptr)
+			batch.x[i] = color.x;
+		if (batch.y != nullptr)
+			batch.y[i] = color.y;
+		if (batch.lux != nullptr)
+			batch.lux[i] = color.lux;
+		if (batch.cct != nullptr)
+			batch.cct[i] = color.cct;
+	}
+}
+
+bool SparkFun_AS7341X_Colorimetry::measure(SparkFun_AS7341X& sensor, AS7341X_COLOR& color)
+{
+	float basicCounts[12];
+	if (!sensor.readAllChannelsBasicCounts(basicCounts))
+		return false;
+	
+	convert(basicCounts, color);
+	return true;
+}
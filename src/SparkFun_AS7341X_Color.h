@@ -0,0 +1,114 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the colorimetry engine of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_COLOR__
+#define __SparkFun_AS7341X_COLOR__
+
+#include <Arduino.h>
+#include "SparkFun_AS7341X_Constants.h"
+
+class SparkFun_AS7341X;
+
+// Number of rows of the correction matrix (X, Y and Z)
+const byte AS7341X_COLOR_ROWS = 3;
+
+// Colorimetric values of one sample
+struct AS7341X_COLOR
+{
+	// CIE 1931 tristimulus values
+	float X;
+	float Y;
+	float Z;
+	
+	// CIE 1931 chromaticity coordinates
+	float x;
+	float y;
+	
+	// Illuminance in lux (Y times the lux scale)
+	float lux;
+	
+	// Correlated color temperature in Kelvin, 0 if the chromaticity is too far from white light
+	float cct;
+};
+
+// Structure-of-arrays batch. channel[c][i] holds the basic counts of channel c (0 = F1 ... 7 = F8, 8 = CLEAR, 9 = NIR)
+// for sample i. X, Y and Z are required, the other outputs are skipped when left as nullptr.
+struct AS7341X_COLOR_BATCH
+{
+	const float* channel[AS7341X_CHANNEL_COUNT];
+	float* X;
+	float* Y;
+	float* Z;
+	float* x;
+	float* y;
+	float* lux;
+	float* cct;
+	uint16_t count;
+};
+
+// Turns basic counts into XYZ with a 3 x 10 correction matrix, then derives chromaticity, lux and CCT.
+// The built-in matrix is fitted to the nominal filter responses and gives relative XYZ; load a matrix
+// calibrated against a reference instrument for accurate results.
+class SparkFun_AS7341X_Colorimetry
+{
+private:
+	// Row major: X, Y and Z rows, one column per channel (F1 ... F8, CLEAR, NIR)
+	float _matrix[AS7341X_COLOR_ROWS][AS7341X_CHANNEL_COUNT];
+	
+	// Lux per unit of Y
+	float _luxScale = 1.0f;
+	
+	// Fills x, y, lux and cct from X, Y and Z
+	void derive(AS7341X_COLOR& color);
+	
+public:
+	// Constructor, loads the built-in matrix
+	SparkFun_AS7341X_Colorimetry();
+	
+	// Loads a 3 x 10 row major matrix from RAM, e.g. after EEPROM.get()
+	void setMatrix(const float* matrix);
+	
+	// Loads a 3 x 10 row major matrix stored in flash with PROGMEM
+	void setMatrix_P(const float* matrix);
+	
+	// Copies the current matrix (30 floats) to matrix, e.g. before EEPROM.put()
+	void getMatrix(float* matrix);
+	
+	// Goes back to the built-in matrix and a lux scale of 1
+	void resetMatrix();
+	
+	// Sets the lux per unit of Y
+	void setLuxScale(float scale);
+	
+	// Returns the lux per unit of Y
+	float getLuxScale();
+	
+	// Sets the lux scale so basicCounts (readAllChannelsBasicCounts layout) reads referenceLux. Returns false if Y is not positive.
+	bool calibrateLux(const float* basicCounts, float referenceLux);
+	
+	// Converts one sample of basic counts (readAllChannelsBasicCounts layout, 12 values)
+	void convert(const float* basicCounts, AS7341X_COLOR& color);
+	
+	// Converts a structure-of-arrays batch. The matrix is applied one channel at a time over all samples.
+	void convert(AS7341X_COLOR_BATCH& batch);
+	
+	// Reads basic counts from sensor and converts them. Returns false if the reading failed.
+	bool measure(SparkFun_AS7341X& sensor, AS7341X_COLOR& color);
+};
+
+#endif // ! __SparkFun_AS7341X_COLOR__
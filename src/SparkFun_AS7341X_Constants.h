@@ -24,6 +24,67 @@
 // Constants definitions
 const byte DEFAULT_AS7341X_ADDR = 0x39;
 
+// Set to 1 (here or with -DAS7341X_IO_STATS=1) to count I2C transactions, bytes and bus time in SparkFun_AS7341X_IO.
+// When 0 the counters and their API are compiled out entirely.
+#ifndef AS7341X_IO_STATS
+#define AS7341X_IO_STATS 0
+#endif
+
+// Number of SMUX RAM bytes (registers 0x00 to 0x13)
+const byte SMUX_TABLE_LENGTH = 20;
+
+// Optical channel masks for readChannels(). Bit n is channel n of the 10 entry result (F1 to F8, Clear, NIR).
+const uint16_t AS7341X_CHANNEL_415NM = 0x0001;
+const uint16_t AS7341X_CHANNEL_445NM = 0x0002;
+const uint16_t AS7341X_CHANNEL_480NM = 0x0004;
+const uint16_t AS7341X_CHANNEL_515NM = 0x0008;
+const uint16_t AS7341X_CHANNEL_555NM = 0x0010;
+const uint16_t AS7341X_CHANNEL_590NM = 0x0020;
+const uint16_t AS7341X_CHANNEL_630NM = 0x0040;
+const uint16_t AS7341X_CHANNEL_680NM = 0x0080;
+const uint16_t AS7341X_CHANNEL_CLEAR = 0x0100;
+const uint16_t AS7341X_CHANNEL_NIR = 0x0200;
+const uint16_t AS7341X_CHANNEL_ALL = 0x03ff;
+
+// Number of optical channels
+const byte AS7341X_CHANNEL_COUNT = 10;
+
+// Number of ADCs, i.e. channels measured per SMUX configuration
+const byte AS7341X_ADC_COUNT = 6;
+
+// Maximum time to wait for a SMUX command or a spectral measurement to complete
+const unsigned long MEASUREMENT_TIMEOUT_MS = 5000;
+
+// Interval between STATUS_2 reads once a spectral measurement is due, in microseconds
+const unsigned int STATUS_POLL_INTERVAL_US = 1000;
+
+// Interval between FD_STATUS reads while getFlickerFrequency waits for a result, in milliseconds
+const unsigned long FLICKER_POLL_INTERVAL_MS = 10;
+
+// Number of two byte entries the AS7341X FIFO can hold
+const byte FIFO_DEPTH = 128;
+
+// Maximum number of FIFO entries fetched per I2C read, keeping each burst within a 32 byte Wire buffer
+const byte FIFO_BURST_ENTRIES = 16;
+
+// Number of decisions kept by the auto-exposure controller
+const byte AUTO_EXPOSURE_HISTORY_LENGTH = 8;
+
+// Number of sensors a SparkFun_AS7341X_Manager can drive
+const byte AS7341X_MANAGER_MAX_SENSORS = 16;
+
+// How far over full scale the auto-exposure controller assumes a saturated reading to be
+const byte AUTO_EXPOSURE_SATURATION_FACTOR = 16;
+
+// Goertzel filters run per pass by the flicker analyzer
+const byte FLICKER_DEFAULT_BINS = 32;
+
+// Time the AS7341X needs after PON before it accepts a SMUX command, in microseconds
+const unsigned int AS7341X_WAKE_DELAY_US = 200;
+
+// Longest spectral cycle period WTIME and WLONG can program, in milliseconds
+const unsigned long AS7341X_MAX_WAIT_TIME_MS = 11387;
+
 // PCA9536 GPIO pins
 const byte POWER_LED_GPIO = 0x0;
 const byte WHITE_LED_GPIO = 0x01;
@@ -36,6 +97,8 @@ const byte ERROR_PCA9536_I2C_COMM_ERROR = 0x02;
 const byte ERROR_AS7341X_WRONG_CHIP_ID = 0x03;
 const byte ERROR_AS7341X_MEASUREMENT_TIMEOUT = 0x04;
 const byte ERROR_AS7341X_INVALID_DEVICE = 0x05;
+const byte ERROR_AS7341X_FIFO_OVERFLOW = 0x06;
+const byte ERROR_AS7341X_INVALID_WAIT_TIME = 0x07;
 
 // Device types
 enum class AS7341X_DEVICE
@@ -61,6 +124,100 @@ enum class AS7341X_GAIN
 	GAIN_INVALID
 };
 
+// Call sites I2C traffic is attributed to when AS7341X_IO_STATS is enabled
+enum class AS7341X_IO_SITE
+{
+	OTHER,
+	BEGIN,
+	READ_ALL_CHANNELS,
+	READ_SINGLE_CHANNEL,
+	READ_CHANNELS,
+	SMUX,
+	FLICKER,
+	FIFO,
+	CONTINUOUS,
+	THRESHOLD,
+	COUNT
+};
+
+// Spectral AGC high hysteresis, in percent of full scale. Gain is reduced above this level.
+enum class AS7341X_AGC_HIGH_HYSTERESIS
+{
+	PERCENT_50,
+	PERCENT_62_5,
+	PERCENT_75,
+	PERCENT_87_5
+};
+
+// Spectral AGC low hysteresis, in percent of full scale. Gain is increased below this level.
+enum class AS7341X_AGC_LOW_HYSTERESIS
+{
+	PERCENT_12_5,
+	PERCENT_25,
+	PERCENT_37_5,
+	PERCENT_50
+};
+
+// Photodiode groups that can be routed to an ADC through SMUX
+enum class AS7341X_PHOTODIODE : byte
+{
+	F1,
+	F2,
+	F3,
+	F4,
+	F5,
+	F6,
+	F7,
+	F8,
+	CLEAR,
+	NIR,
+	FLICKER
+};
+
+// SMUX configurations routing six channels to ADC0 to ADC5 (in this order)
+enum class AS7341X_MUX_CONFIG
+{
+	F1_F4_CLEAR_NIR,
+	F5_F8_CLEAR_NIR
+};
+
+// LEDs on the SparkFun board a differential measurement can drive
+enum class AS7341X_LED
+{
+	WHITE,
+	IR
+};
+
+// How SparkFun_AS7341X_LowPower paces its samples
+enum class AS7341X_POWER_SCHEDULE
+{
+	// The host powers the sensor up, reads all 12 channels and powers it down again for every sample
+	HOST_TIMED,
+	
+	// The sensor paces six channel samples with WTIME and sleeps after each one (SAI) until the host collects it
+	SENSOR_TIMED
+};
+
+// Which side of the threshold window a monitored channel left through
+enum class AS7341X_THRESHOLD_EVENT
+{
+	NONE,
+	BELOW,
+	ABOVE
+};
+
+// Non-blocking measurement states
+enum class AS7341X_MEASUREMENT_STATE
+{
+	IDLE,
+	SMUX_LOW,
+	INTEGRATING_LOW,
+	SMUX_HIGH,
+	INTEGRATING_HIGH,
+	READY,
+	ERROR
+};
+
 // Registers definitions
 const byte REGISTER_CH0_DATA_L		= 0x95;
 const byte REGISTER_CH0_DATA_H		= 0x96;
@@ -84,7 +241,7 @@ const byte REGISTER_GPIO			= 0x73;
 const byte REGISTER_LED				= 0x74;
 const byte REGISTER_ENABLE			= 0x80;
 const byte REGISTER_ATIME			= 0x81;
-const byte REGISTER_WTIME			= 0x82;
+const byte REGISTER_WTIME			= 0x83;
 const byte REGISTER_SP_TH_L_LSB		= 0x84;
 const byte REGISTER_SP_TH_L_MSB		= 0x85;
 const byte REGISTER_SP_TH_H_LSB		= 0x86;
@@ -112,6 +269,7 @@ const byte REGISTER_ASTEP_L			= 0xca;
 const byte REGISTER_ASTEP_H			= 0xcb;
 const byte REGISTER_AGC_GAIN_MAX	= 0xcf;
 const byte REGISTER_AZ_CONFIG		= 0xd6;
+const byte REGISTER_FD_CFG0			= 0xd7;
 const byte REGISTER_FD_TIME_1		= 0xd8;
 const byte REGISTER_FD_TIME_2		= 0xda;
 const byte REGISTER_FD_STATUS		= 0xdb;
@@ -0,0 +1,238 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the flicker waveform analyzer of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_Flicker.h"
+
+// Number of bits needed to hold value
+static byte bitLength(uint32_t value)
+{
+	byte bits = 0;
+	while (value)
+	{
+		bits++;
+		value >>= 1;
+	}
+	return bits;
+}
+
+// (value * coefficient) >> 14 with 32 bit multiplies only. coefficient must be below 2^15 and |value| below 2^30.
+static int32_t mulQ14(int32_t value, int32_t coefficient)
+{
+	int32_t high = value >> 14;
+	int32_t low = value & 0x3fff;
+	return high * coefficient + ((low * coefficient) >> 14);
+}
+
+void SparkFun_AS7341X_FlickerAnalyzer::setFrequencyRange(float minimum, float maximum)
+{
+	_minFrequency = minimum;
+	_maxFrequency = maximum;
+}
+
+void SparkFun_AS7341X_FlickerAnalyzer::setMaxBins(byte bins)
+{
+	if (bins < 4)
+		bins = 4;
+	
+	_maxBins = bins;
+}
+
+void SparkFun_AS7341X_FlickerAnalyzer::setMinModulationDepth(float depth)
+{
+	_minDepth = depth;
+}
+
+float SparkFun_AS7341X_FlickerAnalyzer::power(const uint16_t* samples, uint16_t length, uint16_t mean, byte shift, int32_t coefficient)
+{
+	int32_t s1 = 0;
+	int32_t s2 = 0;
+	
+	for (uint16_t i = 0; i < length; i++)
+	{
+		int32_t x = ((int32_t)samples[i] - mean) >> shift;
+		int32_t s0 = x + mulQ14(s1, coefficient) - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	
+	float f1 = s1;
+	float f2 = s2;
+	return f1 * f1 + f2 * f2 - (coefficient / 16384.0f) * f1 * f2;
+}
+
+float SparkFun_AS7341X_FlickerAnalyzer::blockPower(const uint16_t* samples, uint16_t count, uint16_t blockLength, uint16_t mean, byte shift, float frequency, float sampleRate)
+{
+	// Goertzel coefficient 2 cos(w) in Q14, kept below 2^15 for mulQ14()
+	int32_t coefficient = (int32_t)(32768.0f * cosf(2.0f * PI * frequency / sampleRate));
+	if (coefficient > 32767)
+		coefficient = 32767;
+	
+	float total = 0;
+	uint16_t blocks = 0;
+	for (uint16_t start = 0; start + blockLength <= count; start += blockLength)
+	{
+		total += power(samples + start, blockLength, mean, shift, coefficient);
+		blocks++;
+	}
+	
+	return total / blocks;
+}
+
+float SparkFun_AS7341X_FlickerAnalyzer::sweep(const uint16_t* samples, uint16_t count, uint16_t blockLength, uint16_t mean, byte shift, float sampleRate, float first, float step, byte bins, float& peakPower)
+{
+	// Only the winner and its two neighbours are kept, so memory does not grow with bins
+	float previous = 0;
+	float before = 0;
+	float after = 0;
+	byte peak = 0;
+	peakPower = -1;
+	
+	for (byte bin = 0; bin < bins; bin++)
+	{
+		float current = blockPower(samples, count, blockLength, mean, shift, first + bin * step, sampleRate);
+		if (current > peakPower)
+		{
+			peakPower = current;
+			peak = bin;
+			before = previous;
+			after = 0;
+		}
+		else if (bin == peak + 1)
+		{
+			after = current;
+		}
+		previous = current;
+	}
+	
+	// Parabolic interpolation on magnitudes, skipped at the edges of the sweep
+	float offset = 0;
+	if (peak > 0 && peak < bins - 1)
+	{
+		float a = sqrtf(before);
+		float b = sqrtf(peakPower);
+		float c = sqrtf(after);
+		float denominator = a - 2 * b + c;
+		if (denominator < 0)
+			offset = 0.5f * (a - c) / denominator;
+		if (offset > 0.5f)
+			offset = 0.5f;
+		if (offset < -0.5f)
+			offset = -0.5f;
+	}
+	
+	return first + (peak + offset) * step;
+}
+
+bool SparkFun_AS7341X_FlickerAnalyzer::analyze(const uint16_t* samples, uint16_t count, float sampleRate, AS7341X_FLICKER_RESULT& result)
+{
+	result.frequency = 0;
+	result.amplitude = 0;
+	result.modulationDepth = 0;
+	result.mean = 0;
+	result.minimum = 0;
+	result.maximum = 0;
+	
+	if (count < 16 || sampleRate <= 0)
+		return false;
+	
+	uint32_t sum = 0;
+	uint16_t minimum = 0xffff;
+	uint16_t maximum = 0;
+	for (uint16_t i = 0; i < count; i++)
+	{
+		sum += samples[i];
+		if (samples[i] < minimum)
+			minimum = samples[i];
+		if (samples[i] > maximum)
+			maximum = samples[i];
+	}
+	
+	uint16_t mean = (sum + count / 2) / count;
+	result.mean = mean;
+	result.minimum = minimum;
+	result.maximum = maximum;
+	if (maximum > 0)
+		result.modulationDepth = float(maximum - minimum) / (float(maximum) + float(minimum));
+	
+	// The capture must hold at least one full cycle and the top must stay below Nyquist
+	float bottom = _minFrequency;
+	if (bottom < sampleRate / count)
+		bottom = sampleRate / count;
+	float top = _maxFrequency;
+	if (top > 0.49f * sampleRate)
+		top = 0.49f * sampleRate;
+	if (top <= bottom)
+		return false;
+	
+	if (result.modulationDepth < _minDepth)
+		return true;
+	
+	// A resonating filter grows by up to length^2 / 8 times its input. Scale the DC-free samples
+	// so that stays within 2^28 and the filter states fit 32 bits.
+	int8_t inputBits = 31 - 2 * bitLength(count);
+	if (inputBits < 1)
+		inputBits = 1;
+	if (inputBits > 15)
+		inputBits = 15;
+	uint16_t deviation = (maximum - mean > mean - minimum) ? maximum - mean : mean - minimum;
+	byte deviationBits = bitLength(deviation);
+	byte shift = (deviationBits > inputBits) ? deviationBits - inputBits : 0;
+	
+	// Coarse pass: blocks just short enough for _maxBins filters, one block resolution apart, to span the range
+	float span = top - bottom;
+	uint16_t blockLength = count;
+	if (span * count / sampleRate > _maxBins - 1)
+		blockLength = (uint16_t)((_maxBins - 1) * sampleRate / span);
+	if (blockLength < 16)
+		blockLength = 16;
+	
+	float step = sampleRate / blockLength;
+	byte bins = _maxBins;
+	if (span / step + 1 < bins)
+		bins = (byte)(span / step) + 1;
+	else
+		step = span / (bins - 1);
+	
+	float peakPower;
+	float frequency = sweep(samples, count, blockLength, mean, shift, sampleRate, bottom, step, bins, peakPower);
+	
+	// Fine pass over the whole capture, one coarse step either side of the coarse winner
+	if (blockLength < count)
+	{
+		float fineStep = sampleRate / count;
+		if (2 * step / fineStep + 1 > _maxBins)
+			fineStep = 2 * step / (_maxBins - 1);
+		
+		float first = frequency - step;
+		if (first < bottom)
+			first = bottom;
+		float last = frequency + step;
+		if (last > top)
+			last = top;
+		
+		blockLength = count;
+		frequency = sweep(samples, count, blockLength, mean, shift, sampleRate, first, fineStep, (byte)((last - first) / fineStep) + 1, peakPower);
+	}
+	
+	// One more filter right on the interpolated frequency, so the amplitude does not depend on where the bins fell
+	peakPower = blockPower(samples, count, blockLength, mean, shift, frequency, sampleRate);
+	
+	result.frequency = frequency;
+	result.amplitude = 2.0f * sqrtf(peakPower) * (1UL << shift) / blockLength;
+	return true;
+}
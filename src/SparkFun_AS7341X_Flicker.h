@@ -0,0 +1,83 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the flicker waveform analyzer of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_FLICKER__
+#define __SparkFun_AS7341X_FLICKER__
+
+#include <Arduino.h>
+#include "SparkFun_AS7341X_Constants.h"
+
+// What a flicker waveform looks like
+struct AS7341X_FLICKER_RESULT
+{
+	// Strongest frequency between the analyzer limits in Hz, 0 if the light is steady
+	float frequency;
+	
+	// Amplitude of that frequency component, in counts
+	float amplitude;
+	
+	// Percent flicker, (max - min) / (max + min): 0 = steady ... 1 = light fully off once per cycle
+	float modulationDepth;
+	
+	// Average, lowest and highest sample
+	uint16_t mean;
+	uint16_t minimum;
+	uint16_t maximum;
+};
+
+// Finds the dominant frequency of a captured flicker waveform with a bank of fixed point Goertzel filters.
+// A coarse pass runs short blocks so at most maxBins filters cover the whole range, a fine pass then sweeps
+// the full capture around the winner. Work is bounded by 2 x maxBins x count multiply-adds, and nothing but
+// the samples themselves is stored.
+class SparkFun_AS7341X_FlickerAnalyzer
+{
+private:
+	float _minFrequency = 40.0f;
+	float _maxFrequency = 2500.0f;
+	byte _maxBins = FLICKER_DEFAULT_BINS;
+	
+	// Modulation depth below which the light is reported as steady
+	float _minDepth = 0.02f;
+	
+	// Runs one Goertzel filter over length samples and returns the squared magnitude
+	static float power(const uint16_t* samples, uint16_t length, uint16_t mean, byte shift, int32_t coefficient);
+	
+	// Averages power() over every complete block of blockLength samples
+	static float blockPower(const uint16_t* samples, uint16_t count, uint16_t blockLength, uint16_t mean, byte shift, float frequency, float sampleRate);
+	
+	// Runs bins filters step Hz apart from first Hz upwards. Returns the interpolated peak frequency and its power in peakPower.
+	static float sweep(const uint16_t* samples, uint16_t count, uint16_t blockLength, uint16_t mean, byte shift, float sampleRate, float first, float step, byte bins, float& peakPower);
+	
+public:
+	// Default constructor
+	SparkFun_AS7341X_FlickerAnalyzer() {}
+	
+	// Sets the frequency range searched, in Hz. The top is also limited to just under half the sample rate.
+	void setFrequencyRange(float minimum = 40.0f, float maximum = 2500.0f);
+	
+	// Sets the number of filters run per pass (4 to 255), trading CPU time for resolution of the coarse pass
+	void setMaxBins(byte bins = FLICKER_DEFAULT_BINS);
+	
+	// Sets the modulation depth (0 to 1) below which the light is reported as steady
+	void setMinModulationDepth(float depth = 0.02f);
+	
+	// Analyzes count samples taken at sampleRate Hz. Returns false if there are fewer than 16 samples or the range is empty.
+	bool analyze(const uint16_t* samples, uint16_t count, float sampleRate, AS7341X_FLICKER_RESULT& result);
+};
+
+#endif // ! __SparkFun_AS7341X_FLICKER__
@@ -0,0 +1,310 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the binary frame encoder and decoder of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_Frame.h"
+
+// Sync bytes, version / type and length come before the payload
+const byte FRAME_HEADER_LENGTH = 4;
+
+// Number of channels a sample carries
+static byte channelCount(byte flags)
+{
+	return (flags & AS7341X_SAMPLE_SINGLE_PASS) ? 6 : 12;
+}
+
+// Sequence, timestamp, ATIME, ASTEP, gain and flags, then the channels
+static byte keyPayloadLength(byte flags)
+{
+	return 11 + 2 * channelCount(flags);
+}
+
+static byte* putWord(byte* p, uint16_t value)
+{
+	*p++ = value & 0xff;
+	*p++ = value >> 8;
+	return p;
+}
+
+static uint16_t getWord(const byte* p)
+{
+	return p[0] | (uint16_t)p[1] << 8;
+}
+
+static byte* putVarint(byte* p, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		*p++ = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	*p++ = value;
+	return p;
+}
+
+// Returns nullptr if the varint runs past end
+static const byte* getVarint(const byte* p, const byte* end, uint32_t& value)
+{
+	value = 0;
+	for (byte shift = 0; p < end && shift < 35; shift += 7)
+	{
+		byte b = *p++;
+		value |= (uint32_t)(b & 0x7f) << shift;
+		if ((b & 0x80) == 0)
+			return p;
+	}
+	return nullptr;
+}
+
+uint16_t as7341xFrameCrc(const byte* data, byte length)
+{
+	uint16_t crc = 0xffff;
+	while (length--)
+	{
+		crc ^= (uint16_t)*data++ << 8;
+		for (byte i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+void SparkFun_AS7341X_FrameEncoder::setDeltaEncoding(bool enable)
+{
+	_deltaEncoding = enable;
+}
+
+void SparkFun_AS7341X_FrameEncoder::setKeyFrameInterval(byte interval)
+{
+	_keyFrameInterval = interval;
+}
+
+void SparkFun_AS7341X_FrameEncoder::reset()
+{
+	_sequence = 0;
+	_hasPrevious = false;
+}
+
+uint16_t SparkFun_AS7341X_FrameEncoder::getSequence()
+{
+	return _sequence;
+}
+
+byte SparkFun_AS7341X_FrameEncoder::encodeKey(const AS7341X_SAMPLE& sample, byte* payload)
+{
+	byte* p = putWord(payload, _sequence);
+	p = putWord(p, sample.timestamp & 0xffff);
+	p = putWord(p, sample.timestamp >> 16);
+	*p++ = sample.aTime;
+	p = putWord(p, sample.aStep);
+	*p++ = sample.gain;
+	*p++ = sample.flags;
+	
+	for (byte i = 0; i < channelCount(sample.flags); i++)
+		p = putWord(p, sample.channels[i]);
+	
+	return p - payload;
+}
+
+byte SparkFun_AS7341X_FrameEncoder::encodeDelta(const AS7341X_SAMPLE& sample, byte* payload)
+{
+	byte* p = putWord(payload, _sequence);
+	p = putVarint(p, sample.timestamp - _previous.timestamp);
+	*p++ = sample.flags;
+	
+	for (byte i = 0; i < channelCount(sample.flags); i++)
+	{
+		// Zigzag so small steps either way take a single byte
+		int32_t step = (int32_t)sample.channels[i] - _previous.channels[i];
+		p = putVarint(p, step >= 0 ? (uint32_t)step << 1 : ((uint32_t)(-step) << 1) - 1);
+	}
+	
+	return p - payload;
+}
+
+byte SparkFun_AS7341X_FrameEncoder::encode(const AS7341X_SAMPLE& sample, byte* buffer)
+{
+	byte* payload = buffer + FRAME_HEADER_LENGTH;
+	byte type = AS7341X_FRAME_KEY;
+	byte length = 0;
+	
+	bool deltaAllowed = _deltaEncoding && _hasPrevious &&
+		(_keyFrameInterval == 0 || _framesSinceKey < _keyFrameInterval) &&
+		sample.aTime == _previous.aTime && sample.aStep == _previous.aStep && sample.gain == _previous.gain &&
+		channelCount(sample.flags) == channelCount(_previous.flags);
+	
+	if (deltaAllowed)
+	{
+		// Large jumps make a delta payload longer than a key one, so build it aside and only keep it if it is shorter
+		byte delta[2 + 5 + 1 + 12 * 3];
+		length = encodeDelta(sample, delta);
+		if (length < keyPayloadLength(sample.flags))
+		{
+			memcpy(payload, delta, length);
+			type = AS7341X_FRAME_DELTA;
+		}
+	}
+	
+	if (type == AS7341X_FRAME_KEY)
+	{
+		length = encodeKey(sample, payload);
+		_framesSinceKey = 0;
+	}
+	else
+		_framesSinceKey++;
+	
+	buffer[0] = AS7341X_FRAME_SYNC_1;
+	buffer[1] = AS7341X_FRAME_SYNC_2;
+	buffer[2] = AS7341X_FRAME_VERSION << 4 | type;
+	buffer[3] = length;
+	putWord(payload + length, as7341xFrameCrc(buffer + 2, length + 2));
+	
+	_previous = sample;
+	_hasPrevious = true;
+	_sequence++;
+	
+	return FRAME_HEADER_LENGTH + length + 2;
+}
+
+size_t SparkFun_AS7341X_FrameEncoder::write(const AS7341X_SAMPLE& sample, Print& output)
+{
+	byte frame[AS7341X_FRAME_MAX_LENGTH];
+	byte length = encode(sample, frame);
+	return output.write(frame, length);
+}
+
+void SparkFun_AS7341X_FrameDecoder::reset()
+{
+	_length = 0;
+	_hasPrevious = false;
+}
+
+uint16_t SparkFun_AS7341X_FrameDecoder::getSequence()
+{
+	return _sequence;
+}
+
+uint16_t SparkFun_AS7341X_FrameDecoder::getErrorCount()
+{
+	return _errorCount;
+}
+
+bool SparkFun_AS7341X_FrameDecoder::decode(byte value, AS7341X_SAMPLE& sample)
+{
+	// Hunt for the sync bytes
+	if (_length == 0 && value != AS7341X_FRAME_SYNC_1)
+		return false;
+	if (_length == 1 && value != AS7341X_FRAME_SYNC_2)
+	{
+		_length = (value == AS7341X_FRAME_SYNC_1) ? 1 : 0;
+		return false;
+	}
+	
+	_frame[_length++] = value;
+	
+	// Check version and length as soon as they arrive
+	if (_length == FRAME_HEADER_LENGTH &&
+		((_frame[2] >> 4) != AS7341X_FRAME_VERSION || _frame[3] > AS7341X_FRAME_MAX_LENGTH - FRAME_HEADER_LENGTH - 2))
+	{
+		_errorCount++;
+		_length = 0;
+		return false;
+	}
+	
+	if (_length < FRAME_HEADER_LENGTH || _length < FRAME_HEADER_LENGTH + _frame[3] + 2)
+		return false;
+	
+	// Whole frame received
+	_length = 0;
+	byte payloadLength = _frame[3];
+	if (as7341xFrameCrc(_frame + 2, payloadLength + 2) != getWord(_frame + FRAME_HEADER_LENGTH + payloadLength))
+	{
+		_errorCount++;
+		return false;
+	}
+	
+	if (!decodeFrame(sample))
+	{
+		_errorCount++;
+		return false;
+	}
+	
+	return true;
+}
+
+bool SparkFun_AS7341X_FrameDecoder::decodeFrame(AS7341X_SAMPLE& sample)
+{
+	const byte* p = _frame + FRAME_HEADER_LENGTH;
+	const byte* end = p + _frame[3];
+	byte type = _frame[2] & 0x0f;
+	uint16_t sequence = getWord(p);
+	p += 2;
+	
+	AS7341X_SAMPLE decoded;
+	if (type == AS7341X_FRAME_KEY)
+	{
+		if (end - p < 10)
+			return false;
+		decoded.timestamp = getWord(p) | (uint32_t)getWord(p + 2) << 16;
+		decoded.aTime = p[4];
+		decoded.aStep = getWord(p + 5);
+		decoded.gain = p[7];
+		decoded.flags = p[8];
+		p += 9;
+		
+		byte count = channelCount(decoded.flags);
+		if (_frame[3] != keyPayloadLength(decoded.flags))
+			return false;
+		for (byte i = 0; i < 12; i++)
+			decoded.channels[i] = (i < count) ? getWord(p + 2 * i) : 0;
+	}
+	else if (type == AS7341X_FRAME_DELTA)
+	{
+		// Deltas only make sense on top of the frame right before
+		if (!_hasPrevious || sequence != (uint16_t)(_sequence + 1))
+		{
+			_hasPrevious = false;
+			return false;
+		}
+		
+		decoded = _previous;
+		uint32_t value;
+		p = getVarint(p, end, value);
+		if (p == nullptr || p >= end)
+			return false;
+		decoded.timestamp += value;
+		decoded.flags = *p++;
+		
+		for (byte i = 0; i < channelCount(decoded.flags); i++)
+		{
+			p = getVarint(p, end, value);
+			if (p == nullptr)
+				return false;
+			int32_t step = (value & 1) ? -(int32_t)((value + 1) >> 1) : (int32_t)(value >> 1);
+			decoded.channels[i] += step;
+		}
+		if (p != end)
+			return false;
+	}
+	else
+		return false;
+	
+	_previous = decoded;
+	_hasPrevious = true;
+	_sequence = sequence;
+	sample = decoded;
+	return true;
+}
@@ -0,0 +1,128 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the binary frame encoder and decoder of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Frame layout, all multi-byte fields little endian:
+  
+    0xA5 0x5A | version (7:4) type (3:0) | payload length | payload | CRC-16/CCITT-FALSE over version ... payload
+  
+  Key frame payload (type 0):
+    sequence u16 | timestamp u32 | ATIME u8 | ASTEP u16 | gain u8 | flags u8 | channels u16 x 12 (x 6 if AS7341X_SAMPLE_SINGLE_PASS)
+  
+  Delta frame payload (type 1), only sent when ATIME, ASTEP, gain and the channel count are unchanged:
+    sequence u16 | timestamp increment varint | flags u8 | channel increments, zigzag varint each
+  
+  Varints hold 7 bits per byte, least significant group first, bit 7 set on all but the last byte.
+  A delta frame is only valid right after the frame with the previous sequence number.
+*/
+
+#ifndef __SparkFun_AS7341X_FRAME__
+#define __SparkFun_AS7341X_FRAME__
+
+#include <Arduino.h>
+#include "SparkFun_AS7341X_Buffers.h"
+
+// Frame format version
+const byte AS7341X_FRAME_VERSION = 1;
+
+// Frame types
+const byte AS7341X_FRAME_KEY = 0;
+const byte AS7341X_FRAME_DELTA = 1;
+
+// Sync bytes starting every frame
+const byte AS7341X_FRAME_SYNC_1 = 0xa5;
+const byte AS7341X_FRAME_SYNC_2 = 0x5a;
+
+// Longest frame (a key frame with 12 channels). Delta frames never exceed it, a key frame is sent instead.
+const byte AS7341X_FRAME_MAX_LENGTH = 41;
+
+// Turns sample records into frames. Key frames are sent periodically so a receiver can join or recover mid-stream.
+class SparkFun_AS7341X_FrameEncoder
+{
+private:
+	AS7341X_SAMPLE _previous;
+	bool _hasPrevious = false;
+	uint16_t _sequence = 0;
+	bool _deltaEncoding = true;
+	byte _keyFrameInterval = 16;
+	byte _framesSinceKey = 0;
+	
+	// Writes the key frame payload, returns its length
+	byte encodeKey(const AS7341X_SAMPLE& sample, byte* payload);
+	
+	// Writes the delta frame payload, returns its length
+	byte encodeDelta(const AS7341X_SAMPLE& sample, byte* payload);
+	
+public:
+	// Default constructor
+	SparkFun_AS7341X_FrameEncoder() {}
+	
+	// Enables or disables delta frames. Without them every frame is a key frame.
+	void setDeltaEncoding(bool enable);
+	
+	// Sets how many frames may follow a key frame before the next key frame (0 = only when required)
+	void setKeyFrameInterval(byte interval);
+	
+	// Restarts the stream: sequence 0 and a key frame next
+	void reset();
+	
+	// Encodes sample into buffer (AS7341X_FRAME_MAX_LENGTH bytes). Returns the frame length.
+	byte encode(const AS7341X_SAMPLE& sample, byte* buffer);
+	
+	// Encodes sample and writes the frame to output (Serial, a File...). Returns the number of bytes written.
+	size_t write(const AS7341X_SAMPLE& sample, Print& output);
+	
+	// Returns the sequence number the next frame will carry
+	uint16_t getSequence();
+};
+
+// Rebuilds sample records from a byte stream, resynchronizing on the sync bytes after errors or lost data
+class SparkFun_AS7341X_FrameDecoder
+{
+private:
+	byte _frame[AS7341X_FRAME_MAX_LENGTH];
+	byte _length = 0;
+	AS7341X_SAMPLE _previous;
+	bool _hasPrevious = false;
+	uint16_t _sequence = 0;
+	uint16_t _errorCount = 0;
+	
+	// Decodes a complete frame whose CRC matched. Returns false if it can't be used.
+	bool decodeFrame(AS7341X_SAMPLE& sample);
+	
+public:
+	// Default constructor
+	SparkFun_AS7341X_FrameDecoder() {}
+	
+	// Feeds one received byte. Returns true when it completed a valid frame, which is then copied into sample.
+	bool decode(byte value, AS7341X_SAMPLE& sample);
+	
+	// Returns the sequence number of the last decoded frame
+	uint16_t getSequence();
+	
+	// Returns the number of frames dropped for a bad CRC, a bad header or a missing key frame
+	uint16_t getErrorCount();
+	
+	// Forgets any partial frame and waits for a key frame
+	void reset();
+};
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) of length bytes
+uint16_t as7341xFrameCrc(const byte* data, byte length);
+
+#endif // ! __SparkFun_AS7341X_FRAME__
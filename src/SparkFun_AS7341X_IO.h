@@ -21,6 +21,27 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "SparkFun_AS7341X_Constants.h"
+
+// I2C traffic counters, see AS7341X_IO_STATS
+struct SparkFun_AS7341X_IOStats
+{
+	// Bus transactions (a write phase or a read phase each count as one)
+	uint32_t transactions;
+	
+	// Bytes written (register addresses included) and read
+	uint32_t bytesWritten;
+	uint32_t bytesRead;
+	
+	// CFG_0 writes made to switch register banks
+	uint32_t bankSwitches;
+	
+	// Transactions not acknowledged or returning less data than requested
+	uint32_t nacks;
+	
+	// Time spent inside Wire calls, in microseconds
+	uint32_t busMicros;
+};
 
 class SparkFun_AS7341X_IO
 {
@@ -28,8 +49,56 @@ private:
 	TwoWire* _i2cPort;
 	byte _address;
 	
+	// Last known CFG_0 value, used to track the selected register bank
+	byte _cfg0 = 0;
+	
+	// True when _cfg0 mirrors the device register
+	bool _cfg0Valid = false;
+	
+	// Selects the register bank needed for regAddress, touching CFG_0 only if the bank changes
 	void setBankConfiguration(byte regAddress);
 	
+	// Keeps the CFG_0 copy in sync when CFG_0 itself is read or written
+	void trackConfig0(byte registerAddress, byte value);
+	
+	// Number of configuration registers mirrored by the IO layer
+	static const byte SHADOW_REGISTER_COUNT = 9;
+	
+	// Shadow copies of the configuration registers owned by the library
+	byte _shadowValue[SHADOW_REGISTER_COUNT];
+	
+	// One bit per shadow register, set when the copy matches the device
+	uint16_t _shadowValid = 0;
+	
+	// One bit per shadow register, set while the device may change the register on its own
+	uint16_t _shadowVolatile = 0;
+	
+	// Returns the shadow slot for a register or -1 if the register is not shadowed
+	int8_t shadowIndex(byte registerAddress);
+	
+	// Stores a value just read from or written to the device into its shadow slot, if any
+	void updateShadow(byte registerAddress, byte value);
+	
+	// Raw single byte bus accesses, without any bank handling
+	byte readByteFromBus(byte registerAddress);
+	void writeByteToBus(byte registerAddress, byte value);
+	
+	// Wire endTransmission() and requestFrom(), counted when AS7341X_IO_STATS is enabled
+	byte endWrite(byte bytesWritten);
+	byte requestRead(byte packetLength);
+	
+#if AS7341X_IO_STATS
+	// Overall counters and counters per call site
+	SparkFun_AS7341X_IOStats _stats;
+	SparkFun_AS7341X_IOStats _siteStats[byte(AS7341X_IO_SITE::COUNT)];
+	
+	// Call site the traffic is currently attributed to
+	AS7341X_IO_SITE _site = AS7341X_IO_SITE::OTHER;
+	
+	// Adds one transaction to the overall and current call site counters
+	void countTransaction(byte bytesWritten, byte bytesRead, bool nack, unsigned long elapsed);
+#endif
+	
 public:
 	// Default constructor
 	SparkFun_AS7341X_IO() {}
@@ -39,10 +108,13 @@ public:
 	// Returns true if we get a reply from the I2C device.
 	bool isConnected();
 
-	// Read a single byte from a register.
+	// Read a single byte from a register. Shadowed configuration registers are served from memory.
 	byte readSingleByte(byte registerAddress);
 
-	// Writes a single byte into a register.
+	// Reads a single byte straight from the device, bypassing and refreshing the shadow copy.
+	byte fetchSingleByte(byte registerAddress);
+
+	// Writes a single byte into a register. Writes to shadowed registers are skipped if the value is unchanged.
 	void writeSingleByte(byte registerAddress, byte value);
 
 	// Reads multiple bytes from a register into buffer byte array.
@@ -59,6 +131,48 @@ public:
 
 	// Returns true if a specific bit is set in a register. Bit position ranges from 0 (lsb) to 7 (msb).
 	bool isBitSet(byte registerAddress, byte bitPosition);
+	
+	// Forgets the cached register bank so CFG_0 is read back on the next access. Call after a device reset or power cycle.
+	void invalidateBankCache();
+	
+	// Marks a shadowed register as changed by the device itself (e.g. CFG_1 under AGC) so it is always read from and written to the bus.
+	void setShadowVolatile(byte registerAddress, bool isVolatile);
+	
+#if AS7341X_IO_STATS
+	// Copies the overall I2C counters into stats
+	void getStats(SparkFun_AS7341X_IOStats& stats);
+	
+	// Copies the I2C counters of one call site into stats
+	void getStats(AS7341X_IO_SITE site, SparkFun_AS7341X_IOStats& stats);
+	
+	// Zeroes all counters
+	void resetStats();
+	
+	// Attributes the following traffic to site. Returns the previous site so it can be restored.
+	AS7341X_IO_SITE setSite(AS7341X_IO_SITE site);
+#endif
+	
+	// Drops every shadow copy (and the register bank) so they are read back from the device on next use.
+	// Call after changing configuration registers behind the library's back.
+	void resyncShadowRegisters();
 };
 
+#if AS7341X_IO_STATS
+// Attributes the I2C traffic of the enclosing scope to a call site, restoring the previous one on exit
+class SparkFun_AS7341X_IOScope
+{
+private:
+	SparkFun_AS7341X_IO& _io;
+	AS7341X_IO_SITE _previous;
+	
+public:
+	SparkFun_AS7341X_IOScope(SparkFun_AS7341X_IO& io, AS7341X_IO_SITE site) : _io(io), _previous(io.setSite(site)) {}
+	~SparkFun_AS7341X_IOScope() { _io.setSite(_previous); }
+};
+
+#define AS7341X_IO_SCOPE(io, site) SparkFun_AS7341X_IOScope ioScope(io, site)
+#else
+#define AS7341X_IO_SCOPE(io, site)
+#endif
+
 #endif  // ! __SPARKFUN_AS7341X_IO__
@@ -0,0 +1,318 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the duty-cycled low-power acquisition scheduler of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_LowPower.h"
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+void SparkFun_AS7341X_LowPower::setSupply(float voltage, float activeMicroamps, float idleMicroamps, float sleepMicroamps)
+{
+	_supplyVoltage = voltage;
+	_activeCurrent = activeMicroamps;
+	_idleCurrent = idleMicroamps;
+	_sleepCurrent = sleepMicroamps;
+}
+
+bool SparkFun_AS7341X_LowPower::start(unsigned long intervalMs, AS7341X_POWER_SCHEDULE schedule, AS7341X_MUX_CONFIG muxConfig)
+{
+	stop();
+	
+	if (intervalMs < 1)
+		intervalMs = 1;
+	_intervalMs = intervalMs;
+	_schedule = schedule;
+	
+	// One integration step is 2.78 us
+	_tintMicros = (unsigned long)((_sensor->getATIME() + 1) * (uint32_t(_sensor->getASTEP()) + 1) * 2.78f);
+	
+	_awake = false;
+	_minLatency = 0;
+	_lastLatency = 0;
+	_sampleValid = false;
+	resetStatistics();
+	
+	if (_schedule == AS7341X_POWER_SCHEDULE::HOST_TIMED)
+	{
+		// Sleep until the first sample is due, which is right away
+		_cycleMicros = 0;
+		powerDown();
+		_nextDue = millis();
+		_running = true;
+		return true;
+	}
+	
+	_sensor->enable_AS7341X();
+	delayMicroseconds(AS7341X_WAKE_DELAY_US);
+	_sensor->enableLowPowerIdle();
+	
+	// WTIME paces intervals up to AS7341X_MAX_WAIT_TIME_MS and the sensor is released right after each sample.
+	// Longer intervals use the shortest cycle that fits the integration and sleep after the interrupt until the
+	// next sample is one cycle away.
+	unsigned long cycleMs = _intervalMs;
+	if (cycleMs > AS7341X_MAX_WAIT_TIME_MS)
+		cycleMs = _tintMicros / 1000 + 3;
+	if (!_sensor->startContinuousMeasurement(cycleMs, muxConfig))
+	{
+		_sensor->disableLowPowerIdle();
+		powerDown();
+		return false;
+	}
+	
+	// Only once SMUX is configured: SAI acts on any interrupt, and the SINT of the SMUX command would put the
+	// sensor to sleep before the first spectral cycle. Enabling it clears SINT and any stale AINT.
+	_sensor->enableSleepAfterInterrupt();
+	_cycleMicros = (unsigned long)(_sensor->getWaitTime() * 1000);
+	
+	// The first cycle is already running
+	_awake = true;
+	_wakeMicros = micros();
+	_nextDue = millis() + cycleMs;
+	_running = true;
+	return true;
+}
+
+void SparkFun_AS7341X_LowPower::stop()
+{
+	if (!_running)
+		return;
+	
+	if (_schedule == AS7341X_POWER_SCHEDULE::SENSOR_TIMED)
+	{
+		_sensor->stopContinuousMeasurement();
+		_sensor->disableSleepAfterInterrupt();
+		_sensor->disableLowPowerIdle();
+	}
+	powerDown();
+	
+	_running = false;
+	_awake = false;
+}
+
+bool SparkFun_AS7341X_LowPower::isRunning()
+{
+	return _running;
+}
+
+bool SparkFun_AS7341X_LowPower::service()
+{
+	if (!_running)
+		return false;
+	
+	if (!_awake)
+	{
+		// Wake up just early enough for the data to be valid when the sample is due
+		if ((long)(millis() + getWakeLead() - _nextDue) < 0)
+			return false;
+		
+		if (!wake())
+		{
+			// Try again at the next interval
+			_nextDue += _intervalMs;
+			return false;
+		}
+		_awake = true;
+		return false;
+	}
+	
+	unsigned long latency;
+	if (_schedule == AS7341X_POWER_SCHEDULE::HOST_TIMED)
+	{
+		if (!_sensor->poll())
+		{
+			// Give up on this sample if the measurement failed
+			if (_sensor->getMeasurementState() == AS7341X_MEASUREMENT_STATE::ERROR)
+			{
+				powerDown();
+				_awake = false;
+				_nextDue += _intervalMs;
+			}
+			return false;
+		}
+		
+		latency = micros() - _wakeMicros;
+		_sensor->getResult(_sample);
+		powerDown();
+		finishSample(micros() - _wakeMicros, 2);
+	}
+	else
+	{
+		if (!_sensor->updateContinuousMeasurement())
+			return false;
+		
+		// The sensor has been asleep since AINT, the data registers keep the sample until it is woken again
+		latency = micros() - _wakeMicros;
+		_sensor->getLatestSample(_sample);
+		finishSample(_cycleMicros, 1);
+	}
+	
+	_lastLatency = latency;
+	if ((_minLatency == 0) || (latency < _minLatency))
+		_minLatency = latency;
+	
+	return true;
+}
+
+bool SparkFun_AS7341X_LowPower::wake()
+{
+	if (_schedule == AS7341X_POWER_SCHEDULE::SENSOR_TIMED)
+	{
+		// Releasing the spectral interrupt starts the next cycle
+		_sensor->wakeFromSleepAfterInterrupt();
+		_wakeMicros = micros();
+		return true;
+	}
+	
+	_sensor->enable_AS7341X();
+	_wakeMicros = micros();
+	delayMicroseconds(AS7341X_WAKE_DELAY_US);
+	
+	if (!_sensor->startMeasurement())
+	{
+		powerDown();
+		return false;
+	}
+	return true;
+}
+
+void SparkFun_AS7341X_LowPower::finishSample(unsigned long awakeMicros, byte passes)
+{
+	// Integration draws the active current, SMUX, wake up and WTIME waits the idle current
+	float awake = awakeMicros * 1e-6f;
+	float active = passes * _tintMicros * 1e-6f;
+	if (active > awake)
+		active = awake;
+	_activeSeconds += active;
+	_idleSeconds += awake - active;
+	
+	_sampleValid = true;
+	_sampleCount++;
+	_awake = false;
+	
+	// Stay on the interval grid, but don't try to catch up after an overrun
+	_nextDue += _intervalMs;
+	unsigned long now = millis();
+	if ((long)(now - _nextDue) > 0)
+		_nextDue = now;
+}
+
+void SparkFun_AS7341X_LowPower::powerDown()
+{
+	// ENABLE is updated bit by bit, so an SP_EN left set by poll() would restart integration at the next PON,
+	// before SMUX is configured. Clearing it costs nothing when it is already clear.
+	_sensor->disableMeasurements();
+	_sensor->disable_AS7341X();
+}
+
+unsigned long SparkFun_AS7341X_LowPower::getWakeLead()
+{
+	// Follow the latest latency so a slow wake up does not make every sample late
+	unsigned long latency = (_lastLatency != 0) ? _lastLatency : getMinimumLatency();
+	return (latency + 999) / 1000;
+}
+
+unsigned long SparkFun_AS7341X_LowPower::getIdleTime()
+{
+	if (!_running)
+		return 0;
+	
+	if (_awake)
+	{
+		// A host timed measurement needs poll() to step through SMUX and both integrations
+		if (_schedule == AS7341X_POWER_SCHEDULE::HOST_TIMED)
+			return 0;
+		
+		unsigned long elapsed = micros() - _wakeMicros;
+		return (elapsed >= _cycleMicros) ? 0 : (_cycleMicros - elapsed) / 1000;
+	}
+	
+	long remaining = (long)(_nextDue - getWakeLead() - millis());
+	return (remaining > 0) ? remaining : 0;
+}
+
+bool SparkFun_AS7341X_LowPower::getResult(AS7341X_SAMPLE& sample)
+{
+	if (!_sampleValid)
+		return false;
+	
+	sample = _sample;
+	return true;
+}
+
+uint32_t SparkFun_AS7341X_LowPower::getSampleCount()
+{
+	return _sampleCount;
+}
+
+unsigned long SparkFun_AS7341X_LowPower::getMinimumLatency()
+{
+	if (_minLatency != 0)
+		return _minLatency;
+	
+	// Nothing measured yet: the sensor needs at least its wake delay and both integrations, or one spectral cycle
+	if (_schedule == AS7341X_POWER_SCHEDULE::HOST_TIMED)
+		return AS7341X_WAKE_DELAY_US + 2 * _tintMicros;
+	
+	return _cycleMicros;
+}
+
+unsigned long SparkFun_AS7341X_LowPower::getLastLatency()
+{
+	return _lastLatency;
+}
+
+float SparkFun_AS7341X_LowPower::getDutyCycle()
+{
+	float elapsed = (millis() - _statsStart) * 1e-3f;
+	if (elapsed <= 0)
+		return 0;
+	
+	float dutyCycle = 100 * (_activeSeconds + _idleSeconds) / elapsed;
+	return (dutyCycle > 100) ? 100 : dutyCycle;
+}
+
+float SparkFun_AS7341X_LowPower::getAverageCurrent()
+{
+	float elapsed = (millis() - _statsStart) * 1e-3f;
+	if (elapsed <= 0)
+		return 0;
+	
+	float asleep = elapsed - _activeSeconds - _idleSeconds;
+	if (asleep < 0)
+		asleep = 0;
+	
+	// Charge in microcoulombs over the elapsed time
+	float charge = _activeCurrent * _activeSeconds + _idleCurrent * _idleSeconds + _sleepCurrent * asleep;
+	return charge / elapsed;
+}
+
+float SparkFun_AS7341X_LowPower::getEnergyPerSample()
+{
+	if (_sampleCount == 0)
+		return 0;
+	
+	// Microamps x volts x seconds = microjoules
+	float elapsed = (millis() - _statsStart) * 1e-3f;
+	return getAverageCurrent() * _supplyVoltage * elapsed / _sampleCount;
+}
+
+void SparkFun_AS7341X_LowPower::resetStatistics()
+{
+	_sampleCount = 0;
+	_statsStart = millis();
+	_activeSeconds = 0;
+	_idleSeconds = 0;
+}
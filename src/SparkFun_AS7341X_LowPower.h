@@ -0,0 +1,136 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the duty-cycled low-power acquisition scheduler of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_LOW_POWER__
+#define __SparkFun_AS7341X_LOW_POWER__
+
+#include <Arduino.h>
+#include "SparkFun_AS7341X_Constants.h"
+#include "SparkFun_AS7341X_Buffers.h"
+
+class SparkFun_AS7341X;
+
+// Takes one sample every interval and keeps the sensor asleep in between. HOST_TIMED powers the sensor down (PON off)
+// between samples and wakes it just early enough for the result to be valid when the sample is due. SENSOR_TIMED keeps
+// PON on but lets WTIME pace the sensor, idles it in low power mode and makes it sleep after every cycle (SAI) until the
+// next one is needed. Both modes track the wake to valid latency, the fraction of time the sensor was awake and an
+// energy estimate based on the supply currents set with setSupply().
+class SparkFun_AS7341X_LowPower
+{
+private:
+	SparkFun_AS7341X* _sensor;
+	
+	AS7341X_POWER_SCHEDULE _schedule = AS7341X_POWER_SCHEDULE::HOST_TIMED;
+	unsigned long _intervalMs = 1000;
+	bool _running = false;
+	
+	// Supply voltage in volts and supply currents in microamps while integrating, idle (powered, not integrating) and asleep.
+	// Defaults are approximate datasheet figures, measure your board for better estimates.
+	float _supplyVoltage = 1.8f;
+	float _activeCurrent = 300;
+	float _idleCurrent = 45;
+	float _sleepCurrent = 1;
+	
+	// Spectral cycle period in SENSOR_TIMED mode and integration time, in microseconds
+	unsigned long _cycleMicros = 0;
+	unsigned long _tintMicros = 0;
+	
+	// True from waking the sensor (PON or SAI release) until its sample has been read
+	bool _awake = false;
+	unsigned long _wakeMicros = 0;
+	
+	// millis() value when the next sample is due
+	unsigned long _nextDue = 0;
+	
+	// Shortest and latest wake to valid data time, in microseconds. 0 until measured.
+	unsigned long _minLatency = 0;
+	unsigned long _lastLatency = 0;
+	
+	// Statistics since start() or resetStatistics(). Times are in seconds.
+	uint32_t _sampleCount = 0;
+	unsigned long _statsStart = 0;
+	float _activeSeconds = 0;
+	float _idleSeconds = 0;
+	
+	// Latest sample
+	AS7341X_SAMPLE _sample;
+	bool _sampleValid = false;
+	
+	// Wakes the sensor for the next sample
+	bool wake();
+	
+	// Books the time the sensor was awake for one sample and schedules the next one
+	void finishSample(unsigned long awakeMicros, byte passes);
+	
+	// Stops the spectral engine and clears PON
+	void powerDown();
+	
+	// Returns the time to wake the sensor ahead of the due time, in milliseconds
+	unsigned long getWakeLead();
+	
+public:
+	// Constructor, binds the scheduler to a sensor
+	SparkFun_AS7341X_LowPower(SparkFun_AS7341X& sensor) : _sensor(&sensor) {}
+	
+	// Sets the supply voltage and the currents used by the energy estimate, in microamps
+	void setSupply(float voltage = 1.8f, float activeMicroamps = 300, float idleMicroamps = 45, float sleepMicroamps = 1);
+	
+	// Starts sampling every intervalMs. SENSOR_TIMED measures the six channels of muxConfig only.
+	// Intervals longer than AS7341X_MAX_WAIT_TIME_MS are reached by sleeping after interrupt in SENSOR_TIMED mode.
+	// SENSOR_TIMED fails with ERROR_AS7341X_INVALID_WAIT_TIME if intervalMs is shorter than the integration time.
+	bool start(unsigned long intervalMs, AS7341X_POWER_SCHEDULE schedule = AS7341X_POWER_SCHEDULE::HOST_TIMED,
+		AS7341X_MUX_CONFIG muxConfig = AS7341X_MUX_CONFIG::F1_F4_CLEAR_NIR);
+	
+	// Stops sampling and leaves the sensor powered down. Call enable_AS7341X() before using it directly again.
+	void stop();
+	
+	// Returns true while the scheduler is running
+	bool isRunning();
+	
+	// Advances the schedule without waiting. Returns true when a new sample was captured.
+	bool service();
+	
+	// Returns how long the MCU may sleep before service() needs to be called again, in milliseconds
+	unsigned long getIdleTime();
+	
+	// Copies the latest sample. Returns false if there is none yet.
+	bool getResult(AS7341X_SAMPLE& sample);
+	
+	// Returns the number of samples captured since the statistics were reset
+	uint32_t getSampleCount();
+	
+	// Returns the shortest wake to valid data time observed, in microseconds, or the expected one before the first sample
+	unsigned long getMinimumLatency();
+	
+	// Returns the wake to valid data time of the latest sample, in microseconds
+	unsigned long getLastLatency();
+	
+	// Returns the percentage of time the sensor was awake (integrating or idle) since the statistics were reset
+	float getDutyCycle();
+	
+	// Returns the estimated sensor energy per sample, including the sleep time in between, in microjoules
+	float getEnergyPerSample();
+	
+	// Returns the estimated average sensor current since the statistics were reset, in microamps
+	float getAverageCurrent();
+	
+	// Zeroes the sample count, duty cycle and energy statistics
+	void resetStatistics();
+};
+
+#endif // ! __SparkFun_AS7341X_LOW_POWER__
@@ -0,0 +1,179 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file defines the manager driving several AS7341X sensors at once.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SparkFun_AS7341X_Manager.h"
+#include "SparkFun_AS7341X_Arduino_Library.h"
+
+void SparkFun_AS7341X_Manager::setMuxSelect(AS7341X_MUX_SELECT select, void* context)
+{
+	_select = select;
+	_selectContext = context;
+	_selectedChannel = 0xff;
+}
+
+void SparkFun_AS7341X_Manager::invalidateMuxSelection()
+{
+	_selectedChannel = 0xff;
+}
+
+int SparkFun_AS7341X_Manager::addSensor(SparkFun_AS7341X& sensor, TwoWire& wirePort, byte muxChannel)
+{
+	if (_count >= AS7341X_MANAGER_MAX_SENSORS)
+		return -1;
+	
+	Slot& slot = _slots[_count];
+	slot.sensor = &sensor;
+	slot.wirePort = &wirePort;
+	slot.muxChannel = muxChannel;
+	slot.busy = false;
+	slot.ready = false;
+	return _count++;
+}
+
+byte SparkFun_AS7341X_Manager::getSensorCount()
+{
+	return _count;
+}
+
+SparkFun_AS7341X* SparkFun_AS7341X_Manager::getSensor(byte index)
+{
+	if (index >= _count)
+		return nullptr;
+	
+	return _slots[index].sensor;
+}
+
+void SparkFun_AS7341X_Manager::select(byte index)
+{
+	if (_select == nullptr || _slots[index].muxChannel == _selectedChannel)
+		return;
+	
+	_select(_slots[index].muxChannel, _selectContext);
+	_selectedChannel = _slots[index].muxChannel;
+}
+
+bool SparkFun_AS7341X_Manager::beginAll(byte AS7341X_address)
+{
+	bool result = true;
+	
+	for (byte i = 0; i < _count; i++)
+	{
+		select(i);
+		// begin() already powers the sensor up
+		if (!_slots[i].sensor->begin(AS7341X_address, *_slots[i].wirePort))
+			result = false;
+	}
+	
+	return result;
+}
+
+bool SparkFun_AS7341X_Manager::startAll()
+{
+	bool result = true;
+	_errorCount = 0;
+	_next = 0;
+	
+	for (byte i = 0; i < _count; i++)
+	{
+		select(i);
+		_slots[i].ready = false;
+		_slots[i].busy = _slots[i].sensor->startMeasurement();
+		if (!_slots[i].busy)
+		{
+			_errorCount++;
+			result = false;
+		}
+	}
+	
+	return result;
+}
+
+int SparkFun_AS7341X_Manager::service()
+{
+	// Visit every sensor at most once, starting after the last one serviced
+	for (byte visited = 0; visited < _count; visited++)
+	{
+		byte i = _next;
+		_next = (_next + 1) % _count;
+		
+		Slot& slot = _slots[i];
+		if (!slot.busy)
+			continue;
+		
+		select(i);
+		if (slot.sensor->poll())
+		{
+			slot.busy = false;
+			slot.ready = true;
+			return i;
+		}
+		
+		if (slot.sensor->getMeasurementState() == AS7341X_MEASUREMENT_STATE::ERROR)
+		{
+			slot.busy = false;
+			_errorCount++;
+		}
+	}
+	
+	return -1;
+}
+
+bool SparkFun_AS7341X_Manager::isComplete()
+{
+	for (byte i = 0; i < _count; i++)
+		if (_slots[i].busy)
+			return false;
+	
+	return true;
+}
+
+bool SparkFun_AS7341X_Manager::isReady(byte index)
+{
+	if (index >= _count)
+		return false;
+	
+	return _slots[index].ready;
+}
+
+bool SparkFun_AS7341X_Manager::getResult(byte index, unsigned int* channelData)
+{
+	if (index >= _count || !_slots[index].ready)
+		return false;
+	
+	// Results are kept by the sensor object, no bus access needed
+	return _slots[index].sensor->getResult(channelData);
+}
+
+byte SparkFun_AS7341X_Manager::getErrorCount()
+{
+	return _errorCount;
+}
+
+bool SparkFun_AS7341X_Manager::readAll(unsigned int* channelData)
+{
+	startAll();
+	
+	while (!isComplete())
+	{
+		int index = service();
+		if (index >= 0)
+			getResult(index, channelData + 12 * index);
+	}
+	
+	return (_errorCount == 0);
+}
@@ -0,0 +1,112 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the manager driving several AS7341X sensors at once.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_MANAGER__
+#define __SparkFun_AS7341X_MANAGER__
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "SparkFun_AS7341X_Constants.h"
+
+class SparkFun_AS7341X;
+
+// Routes the bus to a sensor behind an I2C multiplexer, e.g. by writing (1 << channel) to a TCA9548A
+typedef void (*AS7341X_MUX_SELECT)(byte channel, void* context);
+
+// Drives several sensors with the non-blocking measurement API so their integrations overlap.
+// A full cycle takes about one measurement time instead of one per sensor.
+class SparkFun_AS7341X_Manager
+{
+private:
+	struct Slot
+	{
+		SparkFun_AS7341X* sensor;
+		TwoWire* wirePort;
+		byte muxChannel;
+		
+		// True while a measurement is running
+		bool busy;
+		
+		// True once the last measurement finished successfully
+		bool ready;
+	};
+	
+	Slot _slots[AS7341X_MANAGER_MAX_SENSORS];
+	byte _count = 0;
+	
+	AS7341X_MUX_SELECT _select = nullptr;
+	void* _selectContext = nullptr;
+	
+	// Multiplexer channel currently selected, 0xff if unknown
+	byte _selectedChannel = 0xff;
+	
+	// Next sensor service() looks at, so no sensor is starved
+	byte _next = 0;
+	
+	// Number of measurements that ended in an error during the current cycle
+	byte _errorCount = 0;
+	
+	// Routes the bus to a sensor, calling the select callback only when the channel changes
+	void select(byte index);
+	
+public:
+	// Default constructor
+	SparkFun_AS7341X_Manager() {}
+	
+	// Sets the multiplexer select callback. Without one, sensors must sit on different buses or addresses.
+	void setMuxSelect(AS7341X_MUX_SELECT select, void* context = nullptr);
+	
+	// Forgets the selected multiplexer channel, e.g. after another driver used the multiplexer
+	void invalidateMuxSelection();
+	
+	// Adds a sensor. muxChannel is passed to the select callback. Returns the sensor index or -1 if full.
+	int addSensor(SparkFun_AS7341X& sensor, TwoWire& wirePort = Wire, byte muxChannel = 0);
+	
+	// Returns the number of sensors added
+	byte getSensorCount();
+	
+	// Returns a sensor by index, or nullptr
+	SparkFun_AS7341X* getSensor(byte index);
+	
+	// Initializes and powers up every sensor. Returns false if any of them failed.
+	bool beginAll(byte AS7341X_address = DEFAULT_AS7341X_ADDR);
+	
+	// Starts a measurement on every sensor. Returns false if any of them could not be started.
+	bool startAll();
+	
+	// Polls each running sensor once and returns the index of the first one that finished, or -1 if none did
+	int service();
+	
+	// Returns true when no sensor is measuring anymore
+	bool isComplete();
+	
+	// Returns true if the sensor's last measurement finished successfully
+	bool isReady(byte index);
+	
+	// Copies the 12 raw channel values of a finished sensor. Returns false if it has no valid result.
+	bool getResult(byte index, unsigned int* channelData);
+	
+	// Returns the number of sensors whose measurement failed in the current cycle
+	byte getErrorCount();
+	
+	// Blocking cycle: starts all sensors and services them until all are done.
+	// channelData holds 12 values per sensor. Returns true if every sensor produced a result.
+	bool readAll(unsigned int* channelData);
+};
+
+#endif // ! __SparkFun_AS7341X_MANAGER__
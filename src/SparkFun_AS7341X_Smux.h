@@ -0,0 +1,101 @@
+/*
+  This is a library written for the AMS AS7341X 10-Channel Spectral Sensor Frontend
+  SparkFun sells these at its website:
+  https://www.sparkfun.com/products/17719
+
+  Do you like this library? Help support open source hardware. Buy a board!
+
+  Written by Ricardo Ramos  @ SparkFun Electronics, March 15th, 2021
+  This file declares the compile time SMUX RAM image generator of the AS7341X sensor library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SparkFun_AS7341X_SMUX__
+#define __SparkFun_AS7341X_SMUX__
+
+#include <Arduino.h>
+#include "SparkFun_AS7341X_Constants.h"
+
+// Builds SMUX RAM images from "photodiode -> ADC" routes at compile time. Every SMUX RAM nibble connects one
+// photodiode to an ADC (1 based, 0 = disconnected), and each optical channel is made of up to two photodiodes.
+// Example, F1 on ADC0 and NIR on ADC1, stored in flash:
+//   static const byte mySmux[SMUX_TABLE_LENGTH] PROGMEM = AS7341X_SMUX_IMAGE(
+//     SparkFun_AS7341X_Smux::route(AS7341X_PHOTODIODE::F1, 0), SparkFun_AS7341X_Smux::route(AS7341X_PHOTODIODE::NIR, 1));
+struct SparkFun_AS7341X_Smux
+{
+	// Encodes a SMUX nibble location as (address << 1) | high nibble
+	static constexpr byte location(byte address, byte highNibble)
+	{
+		return (address << 1) | highNibble;
+	}
+	
+	// Returns the location of the index-th (0 or 1) photodiode of a channel, 0xff if there is none
+	static constexpr byte pixel(AS7341X_PHOTODIODE photodiode, byte index)
+	{
+		return photodiode == AS7341X_PHOTODIODE::F1 ? (index ? location(0x10, 0) : location(0x01, 0)) :
+			photodiode == AS7341X_PHOTODIODE::F2 ? (index ? location(0x0c, 1) : location(0x05, 0)) :
+			photodiode == AS7341X_PHOTODIODE::F3 ? (index ? location(0x0f, 1) : location(0x00, 1)) :
+			photodiode == AS7341X_PHOTODIODE::F4 ? (index ? location(0x0d, 0) : location(0x05, 1)) :
+			photodiode == AS7341X_PHOTODIODE::F5 ? (index ? location(0x09, 1) : location(0x06, 1)) :
+			photodiode == AS7341X_PHOTODIODE::F6 ? (index ? location(0x0e, 1) : location(0x04, 0)) :
+			photodiode == AS7341X_PHOTODIODE::F7 ? (index ? location(0x0a, 0) : location(0x07, 0)) :
+			photodiode == AS7341X_PHOTODIODE::F8 ? (index ? location(0x0e, 0) : location(0x03, 1)) :
+			photodiode == AS7341X_PHOTODIODE::CLEAR ? (index ? location(0x11, 1) : location(0x08, 1)) :
+			photodiode == AS7341X_PHOTODIODE::NIR ? (index ? 0xff : location(0x13, 0)) :
+			photodiode == AS7341X_PHOTODIODE::FLICKER ? (index ? 0xff : location(0x13, 1)) :
+			0xff;
+	}
+	
+	// Encodes a route from a photodiode to an ADC (0 to 5)
+	static constexpr byte route(AS7341X_PHOTODIODE photodiode, byte adc)
+	{
+		return (byte(photodiode) << 4) | (adc & 0x0f);
+	}
+	
+	// Returns the nibble value a single route puts at a location
+	static constexpr byte nibble(byte location, byte route)
+	{
+		return (pixel(AS7341X_PHOTODIODE(route >> 4), 0) == location || pixel(AS7341X_PHOTODIODE(route >> 4), 1) == location) ?
+			(route & 0x0f) + 1 : 0;
+	}
+	
+	// Returns the nibble value a list of routes puts at a location
+	static constexpr byte nibble(byte /* location */)
+	{
+		return 0;
+	}
+	
+	template <typename... Routes>
+	static constexpr byte nibble(byte location, byte route, Routes... routes)
+	{
+		return nibble(location, route) | nibble(location, routes...);
+	}
+	
+	// Returns one byte of the SMUX RAM image for a list of routes
+	template <typename... Routes>
+	static constexpr byte imageByte(byte address, Routes... routes)
+	{
+		return nibble(location(address, 0), byte(routes)...) | (nibble(location(address, 1), byte(routes)...) << 4);
+	}
+};
+
+// Brace initializer for a 20 byte SMUX RAM image, evaluated by the compiler from a list of SparkFun_AS7341X_Smux::route()
+#define AS7341X_SMUX_IMAGE(...) { \
+	SparkFun_AS7341X_Smux::imageByte(0x00, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x01, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x02, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x03, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x04, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x05, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x06, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x07, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x08, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x09, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x0a, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x0b, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x0c, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x0d, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x0e, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x0f, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x10, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x11, __VA_ARGS__), \
+	SparkFun_AS7341X_Smux::imageByte(0x12, __VA_ARGS__), SparkFun_AS7341X_Smux::imageByte(0x13, __VA_ARGS__) }
+
+#endif // ! __SparkFun_AS7341X_SMUX__